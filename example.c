@@ -1,4 +1,4 @@
-/* Compile with 'gcc -o example example.c flist.c -lm'*/
+/* Compile with 'gcc -o example example.c flist.c flist_sketch.c flist_sample.c flist_typed.c flist_pair.c flist_window.c flist_extsort.c flist_idx.c -lm' (add -mavx2 for the AVX2 kernels) */
 
 #include <stdio.h>
 #include "flist.h"
@@ -34,6 +34,16 @@ int main() {
 
 	printf("variance: %.3f, s_dev: %.3f, mean: %.3f, sum: %.3f, len: %d, are all just a pointer away...",\
 	        fl7->variance, fl7->std_dev, fl7->mean, fl7->sum, fl7->len);
+
+	/* an flist popped empty still combines with another */
+	flist emptied = fl_make_flist();
+	fl_append(emptied, 1);
+	fl_pop(emptied);
+	flist both = fl_combine(emptied, fl7);
+	if (both == NULL || both->len != fl7->len || !fl_equals(both, fl7)) {
+		printf("\nfl_combine() of an emptied flist lost elements\n");
+		return 1;
+	}
 		
 	return 0;
 }
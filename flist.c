@@ -14,6 +14,8 @@
 #include <stdio.h>
 #include <math.h>
 #include <float.h>
+#include <string.h>
+#include <stdint.h>
 #include "flist.h"
 
 #define FL_EPSILON 1e-9
@@ -48,6 +50,13 @@ int fl_near(double a, double b)
 }
 
 
+/* nonzero if `a` and `b` are the same value bit for bit, so one run can hold both */
+static int fl_same_bits_(double a, double b)
+{
+	return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+
 /**
  * allocate memory for node and assign value.
  *
@@ -69,6 +78,126 @@ fl_node fl_make_node(double n)
 }
 
 
+/**
+ * number of elements held by node `nd`: its run or segment length when `l`
+ * uses the fl_run_type layout, otherwise 1.
+ *
+ * @nolan-h-hamilton
+ */
+int fl_node_count(flist l, fl_node nd)
+{
+	return l->ext ? ((fl_run) nd)->count : 1;
+}
+
+
+/* nonzero if `nd` is a frozen segment (see fl_freeze()) */
+static int fl_is_seg_(flist l, fl_node nd)
+{
+	return l->ext && ((fl_run) nd)->seg;
+}
+
+
+/* allocate a node in the layout used by `l` (an fl_run_type if `l->ext`) */
+static fl_node fl_new_node_(flist l, double n)
+{
+	if (!l->ext)
+		return fl_make_node(n);
+
+	fl_run r = (fl_run) malloc(sizeof(fl_run_type));
+	if (r == NULL) {
+		printf("\nmemory allocation for node failed...returning NULL\n");
+		return NULL;
+	}
+	r->node.num = n;
+	r->node.next = NULL;
+	r->node.prev = NULL;
+	r->count = 1;
+	r->seg = 0;
+	return &r->node;
+}
+
+
+static fl_node fl_locate_(flist l, int k, int *off);
+static void fl_unreverse_(flist l);
+static flist fl_update_measures_(flist l, double n, double s, int add);
+
+
+/*
+ * reverse the element order of `l` in O(1) by toggling `rev`: head and tail
+ * swap roles and so do the two fingerprints. the finger stays on its node,
+ * whose first element is now counted from the other end.
+ */
+static void fl_flip_(flist l)
+{
+	fl_node head = l->head;
+	l->head = l->tail;
+	l->tail = head;
+	unsigned long long hash = l->hash;
+	l->hash = l->hash_rev;
+	l->hash_rev = hash;
+	if (l->finger != NULL)
+		l->finger_idx = l->len - fl_node_count(l, l->finger) - l->finger_idx;
+	l->rev = !l->rev;
+}
+
+
+/* the node holding the elements that follow those of `nd`, see fl_reverse() */
+static fl_node fl_step_(flist l, fl_node nd)
+{
+	return l->rev ? nd->prev : nd->next;
+}
+
+
+/* the node holding the elements that precede those of `nd` */
+static fl_node fl_back_(flist l, fl_node nd)
+{
+	return l->rev ? nd->next : nd->prev;
+}
+
+
+/*
+ * count a step of a traversal from node `a` to node `b` for fl_fragmentation():
+ * it jumps unless `b` lies within two nodes of `a` in memory, as it does
+ * after fl_compact() or for nodes allocated one after another
+ */
+static void fl_track_(flist l, fl_node a, fl_node b)
+{
+	uintptr_t x = (uintptr_t) a;
+	uintptr_t y = (uintptr_t) b;
+	uintptr_t d = x < y ? y - x : x - y;
+	l->walk_steps++;
+	if (d > 2 * (l->ext ? sizeof(fl_run_type) : sizeof(fl_node_type)))
+		l->walk_jumps++;
+}
+
+
+/* nonzero if node `nd` is part of slab `s` */
+static int fl_in_slab_(fl_slab s, fl_node nd)
+{
+	if (s == NULL)
+		return 0;
+	uintptr_t p = (uintptr_t) nd;
+	uintptr_t base = (uintptr_t) s->nodes;
+	return p >= base && p < base + s->stride * s->cap;
+}
+
+
+/* return the memory of node `nd` to its slab (see fl_compact()) or to the heap */
+static void fl_node_dealloc_(flist l, fl_node nd)
+{
+	fl_slab s = l->slab;
+	if (fl_in_slab_(s, nd)) {
+		if (--s->live == 0) {
+			free(s->nodes);
+			free(s);
+			l->slab = NULL;
+		}
+		return;
+	}
+	free(nd);
+}
+
+
 /**
  * allocate memory for and initialize new flist 
  *
@@ -91,891 +220,4072 @@ flist fl_make_flist()
 	l->std_dev = 0;
 	l->mean=0;
 	l->sum=0;
+	l->sum_c = 0;
+	l->sumsq_c = 0;
+	l->m2 = 0;
+	l->m3 = 0;
+	l->m4 = 0;
+	l->skewness = 0;
+	l->kurtosis = 0;
+	l->decay = 0;
+	l->decay_tau = 0;
+	l->ew_mean = 0;
+	l->ew_variance = 0;
+	l->ew_weight = 0;
+	l->ew_ts = 0;
+	l->sketch = NULL;
+	l->sampler = NULL;
+	l->rle = 0;
+	l->ext = 0;
+	l->segs = 0;
+	l->finger = NULL;
+	l->finger_idx = 0;
+	l->aff_a = 1;
+	l->aff_b = 0;
+	l->version = 0;
+	l->log_head = NULL;
+	l->log_tail = NULL;
+	l->log_off = 0;
+	l->intrusive = 0;
+	l->rev = 0;
+	l->hash = 0;
+	l->hash_rev = 0;
+	l->hash_pow = 1;
+	l->mhash = 0;
+	l->hash_ok = 1;
+	l->mhash_ok = 1;
+	l->slab = NULL;
+	l->walk_steps = 0;
+	l->walk_jumps = 0;
+	l->compact_at = 0;
+	l->hash_fixed = 0;
         return l;
 }
 
 
 /**
- * after a node has been removed or added to flist, update mean, sum, len fields in constant time.
- *
- * @nolan-h-hamilton
+ * rebuild the ring of `l` (which must hold no segments) node by node in the
+ * layout given by `ext`, merging equal neighbours into runs if `rle`.
  */
-flist fl_update_measures(flist l, double n, int add)
+static void fl_relayout_(flist l, int ext, int rle)
 {
-	if (l == NULL) {
-		printf("\nfl_update_measures(): flist `l` is NULL, returning NULL\n");
-		return NULL;
+	fl_node nd = l->head;
+	int len = l->len;
+	int old_ext = l->ext;
+	fl_node head = NULL;
+	fl_node tail = NULL;
+	l->ext = ext;
+	l->rle = rle;
+	l->finger = NULL;
+	for (int i = 0; i < len; ) {
+		int count = old_ext ? ((fl_run) nd)->count : 1;
+		fl_node nxt = nd->next;
+		int c = 0;
+		while (c < count) {
+			if (rle && tail != NULL && fl_same_bits_(tail->num, nd->num)) {
+				((fl_run) tail)->count += count - c;
+				break;
+			}
+			fl_node cpy = fl_new_node_(l, nd->num);
+			if (rle)
+				((fl_run) cpy)->count = count - c;
+			cpy->prev = tail;
+			if (tail != NULL)
+				tail->next = cpy;
+			else
+				head = cpy;
+			tail = cpy;
+			c += rle ? count - c : 1;
+		}
+		fl_node_dealloc_(l, nd);
+		nd = nxt;
+		i += count;
 	}
-	
-        if (add) {
-                l->len++;
-                l->sum += n;
-		l->sumsq += n*n;
-        } else {
-                if (l->len <= 1) {
-			l->head->num = 0;
-                        l->len = 0;
-                        l->sum = 0;
-                        l->mean = 0;
-			l->variance = 0;
-			l->sumsq = 0;
-                        return l;
-                }
-                l->sum -= n;
-		l->sumsq -= n*n;
-                l->len -= 1;
-	}
-	/* variance is calculated as: second moment - first moment */
-	double moment2 = l->sumsq / l->len;
-        l->mean = (l->sum) / (l->len);
-	l->variance = moment2 - (l->mean*l->mean);
-	l->std_dev = sqrt(l->variance);
-        return l;
+	if (head != NULL) {
+		head->prev = tail;
+		tail->next = head;
+	}
+	l->head = head;
+	l->tail = tail;
 }
 
 
 /**
- * search for a value in flist and return fl_node if found. O(N).
+ * switch `l` to (`on` != 0) or from run-length storage in O(N). in run-length
+ * mode each node is an fl_run_type holding a run of consecutive elements with
+ * the same bits, so memory and traversal cost scale with the number of runs
+ * rather than the number of elements. values that are only fl_near() each
+ * other get runs of their own, so every element reads back as it was
+ * inserted. measures are unchanged. frozen segments are thawed first.
  *
  * @nolan-h-hamilton
-*/
-fl_node fl_find(flist l, double n) {
-	if (l == NULL || l->len == 0) {
-		printf("\nfl_find(): flist `l` is NULL, returning NULL\n");
+ */
+flist fl_set_rle(flist l, int on)
+{
+	if (l == NULL) {
+		printf("\nfl_set_rle(): flist `l` is NULL, returning NULL\n");
 		return NULL;
 	}
-	
-	fl_node nd = l->head;
-	while (nd != l->tail) {
-		if (fl_near(nd->num, n)) {
-			return nd;
-		}
-		nd = nd->next;
+	on = on != 0;
+	if (l->rle == on)
+		return l;
+	if (l->intrusive) {
+		printf("\nfl_set_rle(): flist holds intrusive nodes, which cannot be merged into runs\n");
+		return l;
 	}
-	
-	if (fl_near(nd->num, n))
-		return nd;
-	
-	return NULL;
+	if (on && l->sampler != NULL) {
+		printf("\nfl_set_rle(): sampled flists keep one node per element, see fl_enable_sample()\n");
+		return l;
+	}
+
+	fl_thaw_all(l);
+	fl_unreverse_(l);
+	fl_relayout_(l, on, on);
+	return l;
 }
 
 
+/*
+ * frozen segments store doubles with the XOR scheme of Facebook's Gorilla:
+ * the first value verbatim (64 bits), then for each value v the XOR x with
+ * its predecessor as
+ *   '0'                                   x == 0
+ *   '10' + meaningful bits                leading/trailing zeros of x fit the
+ *                                         previous window
+ *   '11' + 5 bits lead + 6 bits len + len meaningful bits   otherwise
+ * bits are packed most significant first.
+ */
 
-/**
- *  Compare 2 Flists. If they are equal, return 1. Otherwise return 0. O(N).
- * 
- * @jamesdevftw
-*/
-int fl_equals(flist l, flist m)
+static void fl_bits_put_(unsigned char *buf, size_t *pos, uint64_t v, int n)
 {
-	/* rewrote some of the edge-case/early disqualification
-	 * code (len check, head = sentinel same as head = NULL, etc.
-	 * @nolan-h-hamilton
-	*/
-	if (l == NULL) 
-		return m == NULL;
-	
-	if (m == NULL)
-		return l == NULL;
-	
-	if (l->len != m->len || l->sum != m->sum)
-		return 0;
-	
-	if (l->len == 0 && m->len == 0)
-		return 1;
-	
-	if (l->head == NULL) 
-		return m->head == NULL;
-	
-	if (m->head == NULL)
-		return l->head == NULL;
+	while (n > 0) {
+		int avail = 8 - (int) (*pos & 7);
+		int take = n < avail ? n : avail;
+		unsigned bits = (unsigned) (v >> (n - take)) & ((1u << take) - 1);
+		buf[*pos >> 3] |= (unsigned char) (bits << (avail - take));
+		*pos += take;
+		n -= take;
+	}
+}
 
-        fl_node nd = l->head;
-        fl_node md = m->head;
-        /* Iterate through both lists */
-        while ((nd->next != l->head) && (md->next != m->head))
-        {
 
-	        if (!fl_near(nd->num, md->num))
-                {
-                        return 0;
-                }
-                else
-                {
-                        nd = nd->next;
-                        md = md->next;
-                }
-        }
-        /* Check the last nodes */
-	if (!fl_near(nd->num, md->num))
-        {
-                return 0;
-        }
-        else
-        {
-                return 1;
-        }
+static uint64_t fl_bits_get_(const unsigned char *buf, size_t *pos, int n)
+{
+	uint64_t v = 0;
+	while (n > 0) {
+		int avail = 8 - (int) (*pos & 7);
+		int take = n < avail ? n : avail;
+		unsigned bits = (buf[*pos >> 3] >> (avail - take)) & ((1u << take) - 1);
+		v = (v << take) | bits;
+		*pos += take;
+		n -= take;
+	}
+	return v;
 }
 
 
-/**
- * append to flist in O(1) time
- *
- * @nolan-h-hamilton
-*/
-flist fl_append(flist l, double n)
+static int fl_clz64_(uint64_t x)
 {
-	if (l == NULL) {
-		printf("\nfl_append(): flist `l` does not exist...returning NULL\n");
-	        return NULL;
+	int n = 0;
+	while (!(x & 0x8000000000000000ULL)) {
+		x <<= 1;
+		n++;
 	}
-	
-        fl_node nd = fl_make_node(n);
-        if (l->head == NULL || l->len == 0) {
-                l->head = nd;
-                l->tail = nd;
-                nd->next = nd;
-                nd->prev = nd;
-                return fl_update_measures(l, n, 1);
-        }
+	return n;
+}
 
-        nd->prev = l->tail;
-        nd->next = l->head;
-        l->tail->next = nd;
-        l->tail = nd;
-        l->head->prev = nd;
-        return fl_update_measures(l, n, 1);
+
+static int fl_ctz64_(uint64_t x)
+{
+	int n = 0;
+	while (!(x & 1)) {
+		x >>= 1;
+		n++;
+	}
+	return n;
+}
+
+
+static uint64_t fl_dbits_(double d)
+{
+	uint64_t b;
+	memcpy(&b, &d, sizeof(b));
+	return b;
+}
+
+
+/*
+ * decode the value at bit `*bit` of segment data `data`, given the decoder
+ * state left by the previous value; `restart` at the first value of a block
+ */
+static double fl_seg_decode_(const unsigned char *data, int restart, size_t *bit,
+			     unsigned long long *prev, int *lead, int *mlen)
+{
+	if (restart) {
+		*prev = fl_bits_get_(data, bit, 64);
+		*lead = 0;
+		*mlen = 0;
+	} else if (fl_bits_get_(data, bit, 1)) {
+		if (fl_bits_get_(data, bit, 1)) {
+			*lead = (int) fl_bits_get_(data, bit, 5);
+			*mlen = (int) fl_bits_get_(data, bit, 6);
+			if (*mlen == 0)
+				*mlen = 64;
+		}
+		uint64_t x = fl_bits_get_(data, bit, *mlen);
+		*prev ^= x << (64 - *lead - *mlen);
+	}
+	double d;
+	uint64_t b = *prev;
+	memcpy(&d, &b, sizeof(d));
+	return d;
+}
+
+
+/* decode the next value of the segment `it` is positioned in */
+static double fl_seg_next_(fl_iter it)
+{
+	fl_seg sg = (fl_seg) it->nd;
+	int restart = it->off % FL_SEG_BLOCK == 0;
+	if (restart)
+		it->bit = sg->marks[it->off / FL_SEG_BLOCK];
+	return fl_seg_decode_(sg->data, restart, &it->bit, &it->prev, &it->lead, &it->mlen);
+}
+
+
+/* decode block `b` of segment `nd` into it->blk, to be read backwards */
+static void fl_seg_load_(fl_iter it, fl_node nd, int b)
+{
+	fl_seg sg = (fl_seg) nd;
+	size_t bit = sg->marks[b];
+	unsigned long long prev = 0;
+	int lead = 0;
+	int mlen = 0;
+	int n = sg->run.count - b * FL_SEG_BLOCK;
+	if (n > FL_SEG_BLOCK)
+		n = FL_SEG_BLOCK;
+	for (int i = 0; i < n; i++)
+		it->blk[i] = fl_seg_decode_(sg->data, i == 0, &bit, &prev, &lead, &mlen);
+	it->blk_nd = nd;
+	it->blk_no = b;
+}
+
+
+/* position `it` at the start of segment `nd` alone, read forwards (`rev` == 0) or backwards */
+static void fl_seg_iter_(flist l, fl_node nd, fl_iter it, int rev)
+{
+	it->l = l;
+	it->nd = nd;
+	it->off = 0;
+	it->left = ((fl_run) nd)->count;
+	it->rev = rev;
+	it->blk_nd = NULL;
+}
+
+
+/* value of the element stored as `s`, read through the pending transform */
+static double fl_aff_(flist l, double s)
+{
+	if (l->aff_a == 1 && l->aff_b == 0)
+		return s;
+	return l->aff_a * s + l->aff_b;
 }
 
 
 /**
- * returns the 0-indexed k-th element in O(N)
- *
- * begins traversal at head if `k` <= (l->len / 2)
- * otherwise, begins traversal from tail. N/2 steps
- * are performed in worst-case scenario.
+ * position `it` at the k-th element of `l`. together with fl_iter_next()
+ * this reads elements sequentially in O(1) amortized each, decompressing
+ * frozen segments as a stream instead of thawing them. any structural change
+ * to `l` invalidates `it`.
  *
  * @nolan-h-hamilton
  */
-fl_node fl_get_kth(flist l, int k)
+void fl_iter_at(flist l, int k, fl_iter it)
 {
-        if (l == NULL) {
-		printf("\nfl_get_kth(): flist `l` is NULL...returning NULL\n");
-                return NULL;
-        }
-        if (l->head == NULL) {
-                return NULL;
-        }
+	it->l = l;
+	it->nd = NULL;
+	it->off = 0;
+	it->left = 0;
+	it->rev = 0;
+	it->blk_nd = NULL;
+	if (l == NULL || l->len == 0 || k >= l->len)
+		return;
+	if (k < 0)
+		k = 0;
 
-	/* if index n is past midpoint, traverse list from back */
-	if (k > (l->len/2.0)) {
-		fl_node nd = l->tail;
-		int i = l->len;
-		while (i > k+1  && i > 0) {
-			i--;
-			nd = nd->prev;
-		}
-		return nd;
+	int off;
+	it->left = l->len - k;
+	if (l->rev) {
+		/* the element sits at the mirrored index of the flipped list */
+		it->rev = 1;
+		fl_flip_(l);
+		it->nd = fl_locate_(l, l->len - 1 - k, &off);
+		fl_flip_(l);
+		it->off = fl_node_count(l, it->nd) - 1 - off;
+		return;
 	}
-	else {
-		int i = 0;
-		int l_len = l->len;
-		fl_node nd = l->head;
-		while (i < k && i < l_len) {
-			i++;
-			nd = nd->next;
+	it->nd = fl_locate_(l, k, &off);
+	if (fl_is_seg_(l, it->nd)) {
+		/* decode from the start of the block up to the requested position */
+		it->off = off - off % FL_SEG_BLOCK;
+		while (it->off < off) {
+			fl_seg_next_(it);
+			it->off++;
 		}
-		return nd;
+	} else {
+		it->off = off;
 	}
-	return NULL;	
 }
 
 
 /**
- * add node to beginning of flist. O(1).
+ * store the next element of the flist in `out` and return 1, or return 0
+ * once every element has been read. a pending fl_affine() transform is
+ * applied to the value stored.
  *
- * @nolan-h-hamilton @jamesdevftw
-*/
+ * @nolan-h-hamilton
+ */
+int fl_iter_next(fl_iter it, double * out)
+{
+	if (it == NULL || it->left <= 0)
+		return 0;
 
-flist fl_push(flist l, double n)
+	fl_node nd = it->nd;
+	int c = fl_node_count(it->l, nd);
+	if (fl_is_seg_(it->l, nd) && it->rev) {
+		/* a reversed segment is read a decoded block at a time, from its end */
+		int p = c - 1 - it->off;
+		if (it->blk_nd != nd || it->blk_no != p / FL_SEG_BLOCK)
+			fl_seg_load_(it, nd, p / FL_SEG_BLOCK);
+		*out = it->blk[p % FL_SEG_BLOCK];
+	} else if (fl_is_seg_(it->l, nd)) {
+		*out = fl_seg_next_(it);
+	} else {
+		*out = nd->num;
+	}
+	/* elements are read through a pending fl_affine() transform */
+	*out = fl_aff_(it->l, *out);
+	it->left--;
+	if (++it->off == c) {
+		it->nd = it->rev ? nd->prev : nd->next;
+		it->off = 0;
+		if (it->left > 0)
+			fl_track_(it->l, nd, it->nd);
+	}
+	return 1;
+}
+
+
+/* compress the next `count` elements of `it` into a new, unlinked segment node */
+static fl_node fl_seg_encode_(flist l, fl_iter it, int count)
 {
-	if (l == NULL) {
-		printf("\nfl_push(): flist `l` does not exist...returning NULL\n");
+	fl_seg sg = (fl_seg) malloc(sizeof(fl_seg_type));
+	/* worst case per value: 2 control bits + 5 + 6 + 64 */
+	unsigned char *data = (unsigned char *) calloc(((size_t) count * 77 + 64) / 8 + 1, 1);
+	size_t *marks = (size_t *) malloc(sizeof(size_t) * ((count + FL_SEG_BLOCK - 1) / FL_SEG_BLOCK));
+	if (sg == NULL || data == NULL || marks == NULL) {
+		printf("\nfl_freeze(): memory allocation for segment failed...returning NULL\n");
+		free(sg);
+		free(data);
+		free(marks);
 		return NULL;
 	}
-        fl_node new = fl_make_node(n);
-        if (l->head == NULL) {
-                fl_append(l, n);
-                return l;
-        }
-        new->prev = l->tail;
-        new->next = l->head;
-        l->tail->next = new;
-        l->head->prev = new;
-        l->head = new;
-        return fl_update_measures(l, n, 1);
+
+	size_t pos = 0;
+	uint64_t prev = 0;
+	int lead = -1;
+	int mlen = 0;
+	double first = 0;
+	for (int i = 0; i < count; i++) {
+		double d;
+		fl_iter_next(it, &d);
+		uint64_t b = fl_dbits_(d);
+		if (i == 0)
+			first = d;
+		if (i % FL_SEG_BLOCK == 0) {
+			/* each block starts with a whole value */
+			marks[i / FL_SEG_BLOCK] = pos;
+			fl_bits_put_(data, &pos, b, 64);
+			prev = b;
+			lead = -1;
+			continue;
+		}
+		uint64_t x = b ^ prev;
+		prev = b;
+		if (x == 0) {
+			fl_bits_put_(data, &pos, 0, 1);
+			continue;
+		}
+		int lz = fl_clz64_(x);
+		int tz = fl_ctz64_(x);
+		if (lz > 31)
+			lz = 31;
+		if (lead >= 0 && lz >= lead && tz >= 64 - lead - mlen) {
+			fl_bits_put_(data, &pos, 2, 2);
+			fl_bits_put_(data, &pos, x >> (64 - lead - mlen), mlen);
+		} else {
+			lead = lz;
+			mlen = 64 - lz - tz;
+			fl_bits_put_(data, &pos, 3, 2);
+			fl_bits_put_(data, &pos, (uint64_t) lead, 5);
+			fl_bits_put_(data, &pos, (uint64_t) (mlen & 63), 6);
+			fl_bits_put_(data, &pos, x >> tz, mlen);
+		}
+	}
+
+	/* keep only the bytes used */
+	sg->nbytes = (pos + 7) / 8;
+	sg->data = (unsigned char *) malloc(sg->nbytes);
+	if (sg->data == NULL) {
+		sg->data = data;
+	} else {
+		memcpy(sg->data, data, sg->nbytes);
+		free(data);
+	}
+	sg->marks = marks;
+	sg->run.node.num = first;
+	sg->run.node.prev = NULL;
+	sg->run.node.next = NULL;
+	sg->run.count = count;
+	sg->run.seg = 1;
+	l->segs++;
+	return &sg->run.node;
 }
 
 
 /**
- * remove head node and return head->num in O(1)
- *
- * allows for use of flist as a stack
- *
- * @nolan-h-hamilton
-*/
-double fl_pop(flist l)
+ * apply the transform recorded by fl_affine() to the stored values in O(N).
+ * segments are re-encoded in place and the sketch is rebuilt, since bucket
+ * boundaries do not survive an affine map.
+ */
+static void fl_affine_fold_(flist l)
 {
-        if (l == NULL || l->len == 0) {
-                printf("\nfl_pop(): cannot pop empty flist\n");
-		exit(1);
-        }
-	
-        if (l->head == NULL) {
-                printf("\nfl_pop(): cannot pop emtpy flist\n");
-                exit(1);
+	if (l == NULL || (l->aff_a == 1 && l->aff_b == 0))
+		return;
+
+	fl_node nd = l->head;
+	for (int i = 0; i < l->len; ) {
+		int c = fl_node_count(l, nd);
+		if (fl_is_seg_(l, nd)) {
+			/* fl_iter_next() hands the encoder transformed values */
+			fl_iter_type it;
+			fl_seg_iter_(l, nd, &it, 0);
+			fl_node sg = fl_seg_encode_(l, &it, c);
+			if (sg != NULL) {
+				free(((fl_seg) nd)->data);
+				free(((fl_seg) nd)->marks);
+				((fl_seg) nd)->data = ((fl_seg) sg)->data;
+				((fl_seg) nd)->marks = ((fl_seg) sg)->marks;
+				((fl_seg) nd)->nbytes = ((fl_seg) sg)->nbytes;
+				nd->num = sg->num;
+				free(sg);
+				l->segs--;
+			}
+		} else {
+			nd->num = l->aff_a * nd->num + l->aff_b;
+		}
+		i += c;
+		nd = nd->next;
+	}
+	l->aff_a = 1;
+	l->aff_b = 0;
+	if (l->sketch != NULL)
+		fl_enable_sketch(l, l->sketch->alpha, l->sketch->max_bins);
+}
+
+
+/*
+ * value to store for element `*n` entering `l` at an end without folding the
+ * pending transform: the preimage of `*n`, which is set to the value reads
+ * will return for it (equal up to rounding). a transform without a usable
+ * inverse (a == 0, or a preimage out of range) is folded instead.
+ */
+static double fl_aff_store_(flist l, double * n)
+{
+	if (l->aff_a == 1 && l->aff_b == 0)
+		return *n;
+	double s = (*n - l->aff_b) / l->aff_a;
+	if (!isfinite(s) && isfinite(*n)) {
+		fl_affine_fold_(l);
+		return *n;
+	}
+	*n = fl_aff_(l, s);
+	return s;
+}
+
+
+/*
+ * free node `nd`, including the compressed data of a segment, and drop it as
+ * finger and from the sample. intrusive nodes belong to the caller and are
+ * left alone.
+ */
+static void fl_free_node_(flist l, fl_node nd)
+{
+	if (nd == l->finger)
+		l->finger = NULL;
+	fl_sampler_remove(l->sampler, nd);
+	if (l->intrusive)
+		return;
+	if (fl_is_seg_(l, nd)) {
+		free(((fl_seg) nd)->data);
+		free(((fl_seg) nd)->marks);
+		l->segs--;
+	}
+	fl_node_dealloc_(l, nd);
+}
+
+
+/* count node `nd`, just linked into `l`, as a candidate for the sample */
+static void fl_sample_add_(flist l, fl_node nd)
+{
+	fl_sampler_insert(l->sampler, nd, (long) l->len + 1);
+}
+
+
+/* drop a reference to log block `c`, freeing it and its successors once unreferenced */
+static void fl_chunk_unref_(fl_chunk c)
+{
+	while (c != NULL && --c->refs == 0) {
+		fl_chunk nxt = c->next;
+		free(c);
+		c = nxt;
+	}
+}
+
+
+static fl_chunk fl_chunk_new_()
+{
+	fl_chunk c = (fl_chunk) malloc(sizeof(fl_chunk_type));
+	if (c == NULL) {
+		printf("\nfl_snapshot(): memory allocation for log failed\n");
+		return NULL;
+	}
+	c->next = NULL;
+	c->refs = 1;
+	c->used = 0;
+	return c;
+}
+
+
+/* stop maintaining the snapshot log; snapshots keep their own references */
+static void fl_log_drop_(flist l)
+{
+	fl_chunk_unref_(l->log_head);
+	l->log_head = NULL;
+	l->log_tail = NULL;
+	l->log_off = 0;
+}
+
+
+/*
+ * record a modification other than fl_append()/fl_pop(). the log only
+ * supports those two, so it is dropped and rebuilt by the next fl_snapshot()
+ */
+static void fl_touch_(flist l)
+{
+	l->version++;
+	if (l->log_head != NULL)
+		fl_log_drop_(l);
+}
+
+
+/*
+ * content fingerprints. `hash` is the polynomial sum h(x_i) * B^i modulo the
+ * Mersenne prime 2^61 - 1, so an element can be added or removed at either
+ * end in O(1) (`hash_pow` is B^len), and `hash_rev` the same sum over the
+ * reversed list; `mhash` is the wrapping sum of g(x_i), which ignores order.
+ * both hash the exact bits of each value. a change away from the ends
+ * invalidates `hash` until the next O(N) refresh, while `mhash` is updated
+ * by every insertion and removal and only a transform of the values
+ * invalidates it.
+ */
+#define FL_HASH_P 0x1fffffffffffffffULL
+#define FL_HASH_B 0x1851f42d4c957f2fULL
+/* inverse of FL_HASH_B modulo FL_HASH_P */
+#define FL_HASH_BINV 0x0e784f1e535db749ULL
+
+
+static uint64_t fl_mulmod_(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 p = (unsigned __int128) a * b;
+	uint64_t r = ((uint64_t) p & FL_HASH_P) + (uint64_t) (p >> 61);
+#else
+	/* a, b < 2^61: split into 32-bit halves, reducing 2^64 = 8 mod P */
+	uint64_t a_hi = a >> 32, a_lo = (uint32_t) a;
+	uint64_t b_hi = b >> 32, b_lo = (uint32_t) b;
+	uint64_t mid = a_lo * b_hi + a_hi * b_lo;
+	uint64_t lo = a_lo * b_lo;
+	uint64_t r = (a_hi * b_hi << 3) + (mid >> 29) + ((mid << 35) >> 3)
+		+ (lo & FL_HASH_P) + (lo >> 61);
+	r = (r & FL_HASH_P) + (r >> 61);
+#endif
+	return r >= FL_HASH_P ? r - FL_HASH_P : r;
+}
+
+
+/* splitmix64 finalizer over the bits of `x`; -0.0 hashes like 0.0 */
+static uint64_t fl_mix_(double x, uint64_t seed)
+{
+	uint64_t z = fl_dbits_(x == 0 ? 0.0 : x) + seed;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+
+/* term of element `x` in the polynomial fingerprint */
+static uint64_t fl_hash_term_(double x)
+{
+	return fl_mix_(x, 0x9e3779b97f4a7c15ULL) % FL_HASH_P;
+}
+
+
+/* term of element `x` in the multiset fingerprint */
+static uint64_t fl_mhash_term_(double x)
+{
+	return fl_mix_(x, 0x632be59bd9b4e019ULL);
+}
+
+
+/*
+ * account for `x` being added (`add`) at or removed from the head (`head`)
+ * or tail of `l` in the polynomial fingerprint. must precede the matching
+ * fl_update_measures(), which otherwise takes the change for one in the
+ * middle of the list and invalidates the fingerprint.
+ */
+static void fl_hash_end_(flist l, double x, int add, int head)
+{
+	l->hash_fixed = 1;
+	if (!l->hash_ok)
+		return;
+	uint64_t t = fl_hash_term_(x);
+	/* the head of the list is the tail of the reversed list */
+	if (add && head) {
+		l->hash = (t + fl_mulmod_(l->hash, FL_HASH_B)) % FL_HASH_P;
+		l->hash_rev = (l->hash_rev + fl_mulmod_(t, l->hash_pow)) % FL_HASH_P;
+		l->hash_pow = fl_mulmod_(l->hash_pow, FL_HASH_B);
+	} else if (add) {
+		l->hash = (l->hash + fl_mulmod_(t, l->hash_pow)) % FL_HASH_P;
+		l->hash_rev = (t + fl_mulmod_(l->hash_rev, FL_HASH_B)) % FL_HASH_P;
+		l->hash_pow = fl_mulmod_(l->hash_pow, FL_HASH_B);
+	} else if (head) {
+		l->hash = fl_mulmod_((l->hash + FL_HASH_P - t) % FL_HASH_P, FL_HASH_BINV);
+		l->hash_pow = fl_mulmod_(l->hash_pow, FL_HASH_BINV);
+		l->hash_rev = (l->hash_rev + FL_HASH_P - fl_mulmod_(t, l->hash_pow)) % FL_HASH_P;
+	} else {
+		l->hash_pow = fl_mulmod_(l->hash_pow, FL_HASH_BINV);
+		l->hash = (l->hash + FL_HASH_P - fl_mulmod_(t, l->hash_pow)) % FL_HASH_P;
+		l->hash_rev = fl_mulmod_((l->hash_rev + FL_HASH_P - t) % FL_HASH_P, FL_HASH_BINV);
+	}
+}
+
+
+/* recompute the fingerprints in O(N) if a change invalidated either */
+static void fl_hash_refresh_(flist l)
+{
+	if (l->hash_ok && l->mhash_ok)
+		return;
+	l->hash = 0;
+	l->hash_rev = 0;
+	l->hash_pow = 1;
+	l->mhash = 0;
+	fl_iter_type it;
+	double d;
+	fl_iter_at(l, 0, &it);
+	while (fl_iter_next(&it, &d)) {
+		l->hash = (l->hash + fl_mulmod_(fl_hash_term_(d), l->hash_pow)) % FL_HASH_P;
+		l->hash_rev = (fl_hash_term_(d) + fl_mulmod_(l->hash_rev, FL_HASH_B)) % FL_HASH_P;
+		l->hash_pow = fl_mulmod_(l->hash_pow, FL_HASH_B);
+		l->mhash += fl_mhash_term_(d);
+	}
+	l->hash_ok = 1;
+	l->mhash_ok = 1;
+}
+
+
+/* mirror an fl_append() of `n` in the snapshot log, if active */
+static void fl_log_append_(flist l, double n)
+{
+	if (l->log_head == NULL)
+		return;
+	if (l->log_tail->used == FL_CHUNK_LEN) {
+		fl_chunk c = fl_chunk_new_();
+		if (c == NULL) {
+			fl_log_drop_(l);
+			return;
+		}
+		l->log_tail->next = c;
+		l->log_tail = c;
+	}
+	l->log_tail->num[l->log_tail->used++] = n;
+}
+
+
+/* mirror an fl_pop() in the snapshot log, if active */
+static void fl_log_pop_(flist l)
+{
+	if (l->log_head == NULL)
+		return;
+	l->log_off++;
+	/* every block but the last is full: step past it once it is used up */
+	if (l->log_off >= FL_CHUNK_LEN && l->log_head != l->log_tail) {
+		fl_chunk nxt = l->log_head->next;
+		nxt->refs++;
+		fl_chunk_unref_(l->log_head);
+		l->log_head = nxt;
+		l->log_off -= FL_CHUNK_LEN;
+	}
+}
+
+
+/*
+ * replace nodes first..last (a contiguous part of the ring in `next` order,
+ * possibly all of it) by the chain nfirst..nlast, freeing the old nodes
+ */
+static void fl_splice_(flist l, fl_node first, fl_node last, fl_node nfirst, fl_node nlast)
+{
+	fl_node before = first->prev;
+	fl_node after = last->next;
+	int whole = before == last;
+	int had_head = 0;
+	int had_tail = 0;
+
+	for (fl_node nd = first; ; ) {
+		fl_node nxt = nd->next;
+		had_head |= nd == l->head;
+		had_tail |= nd == l->tail;
+		fl_free_node_(l, nd);
+		if (nd == last)
+			break;
+		nd = nxt;
+	}
+
+	/* the ends of a reversed flist are met in `prev` order */
+	fl_node lfirst = l->rev ? nlast : nfirst;
+	fl_node llast = l->rev ? nfirst : nlast;
+	if (whole) {
+		nfirst->prev = nlast;
+		nlast->next = nfirst;
+		l->head = lfirst;
+		l->tail = llast;
+		return;
+	}
+	nfirst->prev = before;
+	before->next = nfirst;
+	nlast->next = after;
+	after->prev = nlast;
+	if (had_head)
+		l->head = lfirst;
+	if (had_tail)
+		l->tail = llast;
+}
+
+
+/**
+ * decompress segment `nd` back into nodes (runs in run-length mode) in
+ * O(segment length) and return the first of them
+ */
+static fl_node fl_thaw_(flist l, fl_node nd)
+{
+	fl_iter_type it;
+	fl_seg_iter_(l, nd, &it, 0);
+
+	fl_node first = NULL;
+	fl_node last = NULL;
+	/* the stored values, not read through a pending transform */
+	for (; it.off < ((fl_run) nd)->count; it.off++) {
+		double d = fl_seg_next_(&it);
+		if (l->rle && last != NULL && fl_same_bits_(last->num, d)) {
+			((fl_run) last)->count++;
+			continue;
+		}
+		fl_node cpy = fl_new_node_(l, d);
+		cpy->prev = last;
+		if (last != NULL)
+			last->next = cpy;
+		else
+			first = cpy;
+		last = cpy;
+	}
+	fl_splice_(l, nd, nd, first, last);
+	return first;
+}
+
+
+/*
+ * swap the links of every node of a reversed `l` in O(N), so that the ring is
+ * walked through `next` again. the element order is unchanged. only the O(N)
+ * restructuring calls this first; reads and the O(1) operations honor l->rev,
+ * walking `prev` or running on the flipped list, see fl_flip_().
+ */
+static void fl_unreverse_(flist l)
+{
+	if (l == NULL || !l->rev)
+		return;
+	if (l->len == 0) {
+		l->rev = 0;
+		return;
+	}
+	if (l->segs > 0) {
+		/* frozen segments are encoded again backwards; stored values are read */
+		fl_affine_fold_(l);
+		fl_node nd = l->head;
+		for (int i = 0; i < l->len; ) {
+			fl_node nxt = nd->next;
+			int c = fl_node_count(l, nd);
+			if (fl_is_seg_(l, nd)) {
+				fl_iter_type it;
+				fl_seg_iter_(l, nd, &it, 1);
+				fl_node sg = fl_seg_encode_(l, &it, c);
+				if (sg == NULL) {
+					/* as plain nodes, the swap below reverses them */
+					fl_thaw_(l, nd);
+				} else {
+					free(((fl_seg) nd)->data);
+					free(((fl_seg) nd)->marks);
+					((fl_seg) nd)->data = ((fl_seg) sg)->data;
+					((fl_seg) nd)->marks = ((fl_seg) sg)->marks;
+					((fl_seg) nd)->nbytes = ((fl_seg) sg)->nbytes;
+					nd->num = sg->num;
+					free(sg);
+					l->segs--;
+				}
+			}
+			i += c;
+			nd = nxt;
+		}
+	}
+	l->rev = 0;
+	fl_node nd = l->head;
+	do {
+		fl_node nxt = nd->prev;
+		nd->prev = nd->next;
+		nd->next = nxt;
+		nd = nxt;
+	} while (nd != l->head);
+}
+
+
+/**
+ * decompress every frozen segment of `l` in O(N)
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_thaw_all(flist l)
+{
+	if (l == NULL) {
+		printf("\nfl_thaw_all(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	fl_affine_fold_(l);
+	if (l->segs == 0)
+		return l;
+
+	fl_node nd = l->head;
+	for (int i = 0; i < l->len; ) {
+		if (fl_is_seg_(l, nd))
+			nd = fl_thaw_(l, nd);
+		i += fl_node_count(l, nd);
+		nd = nd->next;
+	}
+	return l;
+}
+
+
+/* make sure an element boundary falls right before index `k`, thawing or splitting the node that spans it */
+static void fl_split_before_(flist l, int k)
+{
+	int off;
+	if (k <= 0 || k >= l->len)
+		return;
+	fl_node nd = fl_locate_(l, k, &off);
+	while (off > 0) {
+		if (fl_is_seg_(l, nd)) {
+			fl_thaw_(l, nd);
+		} else {
+			fl_node rest = fl_new_node_(l, nd->num);
+			((fl_run) rest)->count = ((fl_run) nd)->count - off;
+			((fl_run) nd)->count = off;
+			rest->prev = nd;
+			rest->next = nd->next;
+			nd->next->prev = rest;
+			nd->next = rest;
+			if (nd == l->tail)
+				l->tail = rest;
+		}
+		nd = fl_locate_(l, k, &off);
+	}
+}
+
+
+/**
+ * freeze the elements at indexes a::b into a single compressed segment in
+ * O(N). values are XOR-compressed against their predecessor (the Gorilla
+ * time-series encoding), which typically takes a few bits for slowly changing
+ * data instead of a 24-byte node per value. the segment still counts toward
+ * len/sum/sumsq, is read by fl_iter_next(), fl_to_arr() and friends through
+ * streaming decompression, and is thawed back into nodes when a structural
+ * operation (insert/remove at an index inside it, pop/dequeue at it, sort,
+ * reverse) touches it. `l` switches to the fl_run_type node layout if needed.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_freeze(flist l, int a, int b)
+{
+	if (l == NULL) {
+		printf("\nfl_freeze(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	fl_affine_fold_(l);
+	if (!(0 <= a && a <= b && b < l->len)) {
+		printf("\nfl_freeze(): indices out of range\n");
+		return l;
+	}
+	if (l->intrusive) {
+		printf("\nfl_freeze(): flist holds intrusive nodes, which cannot be frozen\n");
+		return l;
+	}
+	if (l->sampler != NULL) {
+		printf("\nfl_freeze(): sampled flists keep one node per element, see fl_enable_sample()\n");
+		return l;
+	}
+	fl_unreverse_(l);
+
+	if (!l->ext)
+		fl_relayout_(l, 1, l->rle);
+	fl_split_before_(l, a);
+	fl_split_before_(l, b + 1);
+
+	int off;
+	fl_node first = fl_locate_(l, a, &off);
+	fl_node last = fl_locate_(l, b, &off);
+	fl_iter_type it;
+	fl_iter_at(l, a, &it);
+	fl_node sg = fl_seg_encode_(l, &it, b - a + 1);
+	if (sg == NULL)
+		return l;
+	fl_splice_(l, first, last, sg, sg);
+	return l;
+}
+
+
+/**
+ * fold a newly inserted value into the exponentially weighted mean/variance
+ * in O(1). in time-decayed mode the weight of past samples has already been
+ * decayed by fl_ew_advance_(), so each sample gets weight 1 relative to the
+ * decayed total; otherwise the fixed smoothing factor `decay` is used.
+ *
+ * @nolan-h-hamilton
+ */
+static void fl_ew_step_(flist l, double *mean, double *variance, double *weight, double n)
+{
+	double alpha;
+	if (l->decay_tau > 0) {
+		*weight += 1;
+		alpha = 1 / *weight;
+	} else {
+		/* the first sample initializes the average */
+		alpha = *weight == 0 ? 1 : l->decay;
+		*weight = 1;
+	}
+	double diff = n - *mean;
+	double incr = alpha * diff;
+	*mean += incr;
+	*variance = (1 - alpha) * (*variance + diff * incr);
+}
+
+
+/* fold sample `n` into the weighted measures of `l` */
+static void fl_update_ew_(flist l, double n)
+{
+	fl_ew_step_(l, &l->ew_mean, &l->ew_variance, &l->ew_weight, n);
+}
+
+
+/* decay the total weight of past samples to time `t` (time-decayed mode) */
+static void fl_ew_advance_(flist l, double t)
+{
+	if (l->decay_tau > 0 && l->ew_weight > 0 && t > l->ew_ts)
+		l->ew_weight *= exp(-(t - l->ew_ts) / l->decay_tau);
+	if (t > l->ew_ts || l->ew_weight == 0)
+		l->ew_ts = t;
+}
+
+
+/**
+ * enable exponentially weighted mean/variance (`ew_mean`, `ew_variance`),
+ * updated in O(1) by every insertion. `alpha` is the weight of the newest
+ * sample; 0 disables. removals do not affect the weighted measures, which
+ * describe the stream of inserted values rather than the current contents.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_set_decay(flist l, double alpha)
+{
+	if (l == NULL) {
+		printf("\nfl_set_decay(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	if (alpha < 0 || alpha > 1) {
+		printf("\nfl_set_decay(): `alpha` must be in [0, 1]\n");
+		return l;
+	}
+
+	l->decay = alpha;
+	l->decay_tau = 0;
+	l->ew_mean = 0;
+	l->ew_variance = 0;
+	l->ew_weight = 0;
+	return l;
+}
+
+
+/**
+ * enable time-decayed mean/variance: a sample observed `dt` time units ago
+ * carries weight exp(-dt / tau) relative to a new one. timestamps are given
+ * with fl_append_ts()/fl_push_ts(); other insertions are treated as observed
+ * at the latest timestamp. 0 disables.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_set_time_decay(flist l, double tau)
+{
+	if (l == NULL) {
+		printf("\nfl_set_time_decay(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	if (tau < 0) {
+		printf("\nfl_set_time_decay(): `tau` must be >= 0\n");
+		return l;
+	}
+
+	l->decay = 0;
+	l->decay_tau = tau;
+	l->ew_mean = 0;
+	l->ew_variance = 0;
+	l->ew_weight = 0;
+	l->ew_ts = 0;
+	return l;
+}
+
+
+/**
+ * attach a DDSketch (see flist_sketch.h) to `l` so that approximate quantiles
+ * are available through fl_quantile() with relative error `alpha` and at most
+ * `max_bins` buckets per sign. existing elements are added once in O(N); from
+ * then on every insertion and removal updates the sketch in O(1).
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_enable_sketch(flist l, double alpha, int max_bins)
+{
+	if (l == NULL) {
+		printf("\nfl_enable_sketch(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	fl_affine_fold_(l);
+
+	fl_sketch sk = fl_sketch_make(alpha, max_bins);
+	if (sk == NULL)
+		return l;
+	fl_iter_type it;
+	double d;
+	fl_iter_at(l, 0, &it);
+	while (fl_iter_next(&it, &d))
+		fl_sketch_add(sk, d, 1);
+	fl_sketch_destroy(l->sketch);
+	l->sketch = sk;
+	return l;
+}
+
+
+/**
+ * approximate `q`-quantile (0 <= q <= 1) of the elements of `l` in
+ * O(sketch size). returns NAN if no sketch is attached or `l` is empty.
+ *
+ * @nolan-h-hamilton
+ */
+double fl_quantile(flist l, double q)
+{
+	if (l == NULL || l->sketch == NULL) {
+		printf("\nfl_quantile(): flist has no sketch, see fl_enable_sketch()\n");
+		return NAN;
+	}
+	/*
+	 * the sketch still holds the values from before a pending fl_affine().
+	 * a negative factor reverses their order: ask for the element of the
+	 * mirrored rank, which 1 - q misses by one when q * (count - 1) is fractional
+	 */
+	if (l->aff_a < 0 && q >= 0 && q <= 1 && l->sketch->count > 1) {
+		double last = l->sketch->count - 1;
+		q = (last - floor(q * last) + 0.5) / last;
+		if (q > 1)
+			q = 1;
+	}
+	return fl_aff_(l, fl_sketch_quantile(l->sketch, q));
+}
+
+
+/**
+ * keep a uniform random sample of up to `size` elements of `l` (see
+ * flist_sample.h), which fl_sample() reads in O(k) regardless of len.
+ * existing elements are fed to it once in O(N); from then on every insertion
+ * and removal updates it in O(1). the sample is kept by node, so a sampled
+ * flist stays in the plain node layout (no fl_set_rle(), fl_freeze()).
+ * 0 disables.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_enable_sample(flist l, int size)
+{
+	if (l == NULL) {
+		printf("\nfl_enable_sample(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	if (l->ext) {
+		printf("\nfl_enable_sample(): flist holds runs or segments, see fl_set_rle(l, 0)\n");
+		return l;
+	}
+	fl_sampler_destroy(l->sampler);
+	l->sampler = NULL;
+	if (size <= 0)
+		return l;
+
+	fl_sampler s = fl_sampler_make(size, 0x6a09e667f3bcc908ULL);
+	if (s == NULL)
+		return l;
+	/* the order of the nodes does not matter, so a reversed ring is fine */
+	fl_node nd = l->head;
+	for (int i = 0; i < l->len; i++, nd = nd->next)
+		fl_sampler_insert(s, nd, (long) i + 1);
+	l->sampler = s;
+	return l;
+}
+
+
+/**
+ * copy min(`k`, sample size) elements of the sample kept by
+ * fl_enable_sample(), drawn uniformly without replacement, to `buf` in O(k)
+ * and return how many. the sample holds `size` elements unless elements were
+ * removed more recently than as many were inserted.
+ *
+ * @nolan-h-hamilton
+ */
+int fl_sample(flist l, double * buf, int k)
+{
+	if (l == NULL || l->sampler == NULL) {
+		printf("\nfl_sample(): flist has no sample, see fl_enable_sample()\n");
+		return 0;
+	}
+	if (buf == NULL || k <= 0)
+		return 0;
+	if (k > l->sampler->len)
+		k = l->sampler->len;
+	void **nodes = (void **) malloc(sizeof(void *) * (k > 0 ? k : 1));
+	if (nodes == NULL) {
+		printf("\nfl_sample(): memory allocation failed, returning 0\n");
+		return 0;
+	}
+	k = fl_sampler_draw(l->sampler, nodes, k);
+	/* the nodes still hold the values from before a pending fl_affine() */
+	for (int i = 0; i < k; i++)
+		buf[i] = fl_aff_(l, ((fl_node) nodes[i])->num);
+	free(nodes);
+	return k;
+}
+
+
+/**
+ * add `x` to the compensated sum *s + *c. the low-order bits lost by the
+ * addition are recovered (Neumaier) and kept in *c, and *s stays the sum
+ * rounded to a double.
+ *
+ * @nolan-h-hamilton
+ */
+void fl_kahan_add(double * s, double * c, double x)
+{
+	double t = *s + x;
+	double e = fabs(*s) >= fabs(x) ? (*s - t) + x : (x - t) + *s;
+	e += *c;
+	*s = t + e;
+	*c = e - (*s - t);
+}
+
+
+/* moments of `c` copies of `x` */
+fl_moments_type fl_moments_of(double x, int c)
+{
+	double sq = x * x;
+	fl_moments_type g = {c, c * x, 0, c * sq, 0, x, 0, 0, 0};
+	/* the rounding errors of the products, exactly */
+	g.sum_c = fma(c, x, -g.sum);
+	g.sumsq_c = c * fma(x, x, -sq) + fma(c, sq, -g.sumsq);
+	return g;
+}
+
+
+/* the part of the mean of `g` that g->mean, rounded to a double, lacks */
+static double fl_mom_mean_lo_(const fl_moments_type * g)
+{
+	return g->n > 0 ? (fma(-g->mean, g->n, g->sum) + g->sum_c) / g->n : 0;
+}
+
+
+static fl_moments_type fl_mom_get_(flist l)
+{
+	fl_moments_type g = {l->len, l->sum, l->sum_c, l->sumsq, l->sumsq_c, l->mean,
+			 l->m2, l->m3, l->m4};
+	return g;
+}
+
+
+/* store `g` as the measures of `l` and derive variance, std_dev, skewness and kurtosis from it */
+static void fl_mom_set_(flist l, const fl_moments_type * g)
+{
+	l->len = g->n;
+	l->sum = g->sum;
+	l->sum_c = g->sum_c;
+	l->sumsq = g->sumsq;
+	l->sumsq_c = g->sumsq_c;
+	l->mean = g->mean;
+	l->m2 = g->m2;
+	l->m3 = g->m3;
+	l->m4 = g->m4;
+	l->variance = g->n > 0 ? g->m2 / g->n : 0;
+	l->std_dev = sqrt(l->variance);
+	l->skewness = 0;
+	l->kurtosis = 0;
+	if (g->m2 > 0) {
+		l->skewness = sqrt((double) g->n) * g->m3 / (g->m2 * sqrt(g->m2));
+		l->kurtosis = g->n * g->m4 / (g->m2 * g->m2) - 3;
+	}
+}
+
+
+/**
+ * merge the group `b` into `a` (add nonzero), or take it out of `a`, which
+ * must contain it. the central moments are updated from the difference of
+ * the group means (Chan et al., Pébay), never from power sums, so they do not
+ * suffer cancellation when the values are large compared to their spread.
+ * for a single value this is Welford's update. returns that difference, the
+ * mean of `b` minus the mean of the other group (`a` before an addition, `a`
+ * after a removal), from which callers update co-moments of paired values.
+ *
+ * @nolan-h-hamilton
+ */
+double fl_moments_merge(fl_moments_type * a, const fl_moments_type * b, int add)
+{
+	if (b->n == 0)
+		return 0;
+	int n = add ? a->n + b->n : a->n - b->n;
+	if (n <= 0) {
+		*a = fl_moments_of(0, 0);
+		return 0;
+	}
+	/*
+	 * the deviation of b's mean from that of the other group merged: `a`
+	 * before an addition, or `a` after a removal. taking the low parts of
+	 * the means into account keeps it exact when the means are large.
+	 */
+	double na = add ? a->n : n;
+	double nb = b->n;
+	double nn = na + nb;
+	double d = 0;
+	if (add)
+		d = (b->mean - a->mean) + (fl_mom_mean_lo_(b) - fl_mom_mean_lo_(a));
+	double sgn = add ? 1 : -1;
+	fl_kahan_add(&a->sum, &a->sum_c, sgn * b->sum);
+	fl_kahan_add(&a->sum, &a->sum_c, sgn * b->sum_c);
+	fl_kahan_add(&a->sumsq, &a->sumsq_c, sgn * b->sumsq);
+	fl_kahan_add(&a->sumsq, &a->sumsq_c, sgn * b->sumsq_c);
+	a->n = n;
+	a->mean = (a->sum + a->sum_c) / n;
+	if (!add)
+		d = (b->mean - a->mean) + (fl_mom_mean_lo_(b) - fl_mom_mean_lo_(a));
+
+	/*
+	 * the combined moment of order k is the sum of the two groups' plus a
+	 * term in the lower-order moments of both; a removal solves for the other
+	 * group's moments in increasing order
+	 */
+	double d2 = d * d;
+	double m2 = a->m2, m3 = a->m3;
+	double t2 = b->m2 + d2 * na * nb / nn;
+	if (add) {
+		a->m2 += t2;
+	} else {
+		a->m2 -= t2;
+		m2 = a->m2 = a->m2 > 0 ? a->m2 : 0;
+	}
+	double t3 = b->m3 + d2 * d * na * nb * (na - nb) / (nn * nn)
+		+ 3 * d * (na * b->m2 - nb * m2) / nn;
+	if (add) {
+		a->m3 += t3;
+	} else {
+		a->m3 -= t3;
+		m3 = a->m3;
+	}
+	double t4 = b->m4 + d2 * d2 * na * nb * (na * na - na * nb + nb * nb) / (nn * nn * nn)
+		+ 6 * d2 * (na * na * b->m2 + nb * nb * m2) / (nn * nn)
+		+ 4 * d * (na * b->m3 - nb * m3) / nn;
+	a->m4 = add ? a->m4 + t4 : a->m4 - t4;
+	if (a->m2 < 0 || a->m4 < 0 || n == 1) {
+		a->m2 = 0;
+		a->m3 = 0;
+		a->m4 = 0;
+	}
+	return d;
+}
+
+
+/**
+ * replace every element x of `l` by a*x + b in O(1). len, sum, sumsq, mean,
+ * variance, std_dev, skewness, kurtosis and the weighted measures are
+ * updated analytically. the
+ * stored values are left untouched: reads (fl_get(), fl_iter_next(),
+ * fl_to_arr(), fl_equals(), ...) apply the transform on the fly. appends,
+ * pushes and batches store the preimage of each new value and pops and
+ * dequeues read through the transform, so they stay O(1); the transform is
+ * folded into the nodes in O(N) by the next operation that changes `l` away
+ * from its ends or hands out its nodes (fl_get_kth(), fl_find()).
+ * successive transforms compose in O(1).
+ *
+ * an attached quantile sketch (fl_enable_sketch()) answers for a pending
+ * scale, which keeps its relative accuracy, but not for a shift, which does
+ * not: a transform that leaves a shift pending (b != 0) is folded right away
+ * in O(N), rebuilding the sketch.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_affine(flist l, double a, double b)
+{
+	if (l == NULL) {
+		printf("\nfl_affine(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	if (l->len == 0)
+		return l;
+
+	fl_touch_(l);
+	l->hash_ok = 0;
+	l->mhash_ok = 0;
+	double sum = l->sum + l->sum_c;
+	l->sumsq *= a*a;
+	l->sumsq_c *= a*a;
+	fl_kahan_add(&l->sumsq, &l->sumsq_c, 2*a*b*sum);
+	fl_kahan_add(&l->sumsq, &l->sumsq_c, b*b*l->len);
+	l->sum *= a;
+	l->sum_c *= a;
+	fl_kahan_add(&l->sum, &l->sum_c, b*l->len);
+	l->mean = a*l->mean + b;
+	l->m2 = a*a*l->m2;
+	l->m3 = a*a*a*l->m3;
+	l->m4 = a*a*a*a*l->m4;
+	l->variance = a*a*l->variance;
+	l->std_dev = fabs(a) * l->std_dev;
+	if (a < 0)
+		l->skewness = -l->skewness;
+	if (a == 0) {
+		l->skewness = 0;
+		l->kurtosis = 0;
+	}
+	if (l->ew_weight > 0) {
+		l->ew_mean = a*l->ew_mean + b;
+		l->ew_variance = a*a*l->ew_variance;
+	}
+	l->aff_b = a*l->aff_b + b;
+	l->aff_a = a*l->aff_a;
+	if (l->sketch != NULL && l->aff_b != 0)
+		fl_affine_fold_(l);
+	return l;
+}
+
+
+/* multiply every element of `l` by `a` in O(1), see fl_affine() */
+flist fl_scale(flist l, double a)
+{
+	return fl_affine(l, a, 0);
+}
+
+
+/* add `b` to every element of `l` in O(1), see fl_affine() */
+flist fl_offset(flist l, double b)
+{
+	return fl_affine(l, 1, b);
+}
+
+
+/**
+ * value of the 0-indexed k-th element of `l`, without thawing a segment or
+ * folding a pending fl_affine() transform. O(1) amortized for sequential k.
+ *
+ * @nolan-h-hamilton
+ */
+double fl_get(flist l, int k)
+{
+	if (l == NULL || k < 0 || k >= l->len) {
+		printf("\nfl_get(): index does not exist, returning NAN\n");
+		return NAN;
+	}
+
+	fl_iter_type it;
+	double d;
+	if (l->rev) {
+		/* read the flipped list instead of unreversing the ring */
+		fl_flip_(l);
+		d = fl_get(l, l->len - 1 - k);
+		fl_flip_(l);
+		return d;
+	}
+	fl_iter_at(l, k, &it);
+	fl_iter_next(&it, &d);
+	return d;
+}
+
+
+/**
+ * after a node has been removed or added to flist, update mean, sum, len fields in constant time.
+ *
+ * sum and sumsq are compensated sums and the variance is derived from a
+ * running sum of squared deviations, so the measures stay accurate over any
+ * number of updates and never need to be recomputed from the elements
+ * (fl_check_measures() does that for debugging).
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_update_measures(flist l, double n, int add)
+{
+	if (l == NULL) {
+		printf("\nfl_update_measures(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	double s = n;
+	if ((l->aff_a != 1 || l->aff_b != 0) && l->aff_a != 0)
+		s = (n - l->aff_b) / l->aff_a;
+	return fl_update_measures_(l, n, s, add);
+}
+
+
+/*
+ * fl_update_measures() for element `n` stored as `s`, which differs from `n`
+ * under a pending fl_affine() transform. the sketch holds stored values.
+ */
+static flist fl_update_measures_(flist l, double n, double s, int add)
+{
+	if (l->sketch != NULL)
+		fl_sketch_add(l->sketch, s, add ? 1 : -1);
+	l->version++;
+	/* changes away from the ends invalidate the polynomial fingerprint */
+	if (l->hash_fixed)
+		l->hash_fixed = 0;
+	else
+		l->hash_ok = 0;
+	if (add)
+		l->mhash += fl_mhash_term_(n);
+	else
+		l->mhash -= fl_mhash_term_(n);
+	
+	if (add && (l->decay > 0 || l->decay_tau > 0))
+		fl_update_ew_(l, n);
+	if (!add && l->len <= 1 && l->head != NULL && !l->intrusive)
+		l->head->num = 0;
+
+	fl_moments_type g = fl_mom_get_(l);
+	fl_moments_type x = fl_moments_of(n, 1);
+	fl_moments_merge(&g, &x, add);
+	fl_mom_set_(l, &g);
+	/* nothing is stored under the transform anymore */
+	if (l->len == 0) {
+		l->aff_a = 1;
+		l->aff_b = 0;
+	}
+        return l;
+}
+
+
+/**
+ * recompute len, sum, sumsq, mean, variance, std_dev, skewness and kurtosis
+ * of `l` from its elements in O(N) and compare them with the incrementally maintained ones.
+ * returns 1 if all agree within tolerance `tol` (relative to the magnitude
+ * of the elements, or of skewness/kurtosis when above 1), otherwise prints
+ * the ones that differ and returns 0. meant for debugging.
+ *
+ * @nolan-h-hamilton
+ */
+int fl_check_measures(flist l, double tol)
+{
+	if (l == NULL) {
+		printf("\nfl_check_measures(): flist `l` is NULL, returning 0\n");
+		return 0;
+	}
+
+	fl_iter_type it;
+	double d;
+	int len = 0;
+	double sum = 0, sum_c = 0, sumsq = 0, sumsq_c = 0;
+	fl_iter_at(l, 0, &it);
+	while (fl_iter_next(&it, &d)) {
+		len++;
+		fl_kahan_add(&sum, &sum_c, d);
+		fl_kahan_add(&sumsq, &sumsq_c, d*d);
+	}
+	double mean = len > 0 ? (sum + sum_c) / len : 0;
+	/* the part of the mean lost to rounding, so the deviations are exact */
+	double mean_lo = len > 0 ? (fma(-mean, len, sum) + sum_c) / len : 0;
+	/* second pass for the central moments, about the mean */
+	double m2 = 0, m2_c = 0, m3 = 0, m3_c = 0, m4 = 0, m4_c = 0;
+	fl_iter_at(l, 0, &it);
+	while (fl_iter_next(&it, &d)) {
+		double e = (d - mean) - mean_lo;
+		fl_kahan_add(&m2, &m2_c, e * e);
+		fl_kahan_add(&m3, &m3_c, e * e * e);
+		fl_kahan_add(&m4, &m4_c, e * e * e * e);
+	}
+	m2 += m2_c;
+	/* a spread within the rounding error of the mean is that of a constant list */
+	if (m2 <= 16 * DBL_EPSILON * DBL_EPSILON * sumsq)
+		m2 = 0;
+	double variance = len > 0 ? m2 / len : 0;
+	double skewness = 0, kurtosis = 0;
+	if (m2 > 0) {
+		skewness = sqrt((double) len) * (m3 + m3_c) / (m2 * sqrt(m2));
+		kurtosis = len * (m4 + m4_c) / (m2 * m2) - 3;
+	}
+
+	const char * names[] = {"sum", "sumsq", "mean", "variance", "std_dev", "skewness", "kurtosis"};
+	double want[] = {sum, sumsq, mean, variance, sqrt(variance), skewness, kurtosis};
+	double have[] = {l->sum, l->sumsq, l->mean, l->variance, l->std_dev, l->skewness, l->kurtosis};
+	/*
+	 * errors in the sums, the mean and the spread are relative to the
+	 * magnitude of the elements, not to the spread itself, which is 0 for
+	 * a constant list. the shape measures are unitless and near 0 for
+	 * symmetric data, so their errors are absolute below magnitude 1.
+	 */
+	double moment2 = sumsq / (len > 0 ? len : 1);
+	double scale[] = {sqrt(sumsq * len), sumsq, sqrt(moment2),
+			  moment2, sqrt(moment2), fmax(1, fabs(skewness)), fmax(1, fabs(kurtosis))};
+	int ok = 1;
+	if (len != l->len) {
+		printf("\nfl_check_measures(): len is %d, recomputed %d\n", l->len, len);
+		ok = 0;
+	}
+	for (int i = 0; i < 7; i++) {
+		if (fabs(have[i] - want[i]) > tol * (scale[i] > 0 ? scale[i] : 1)) {
+			printf("\nfl_check_measures(): %s is %.17g, recomputed %.17g\n",
+			       names[i], have[i], want[i]);
+			ok = 0;
+		}
+	}
+	return ok;
+}
+
+
+/**
+ * search for a value in flist and return fl_node if found. O(N).
+ * a match inside a frozen segment thaws that segment.
+ *
+ * @nolan-h-hamilton
+*/
+fl_node fl_find(flist l, double n) {
+	if (l == NULL || l->len == 0) {
+		printf("\nfl_find(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	fl_affine_fold_(l);
+	
+	fl_node nd = l->head;
+	for (int i = 0; i < l->len; i += fl_node_count(l, nd), fl_track_(l, nd, fl_step_(l, nd)), nd = fl_step_(l, nd)) {
+		if (fl_is_seg_(l, nd)) {
+			/* scan the segment as a stream; thaw it only on a match */
+			fl_iter_type it;
+			double d;
+			fl_iter_at(l, i, &it);
+			for (int j = 0; j < fl_node_count(l, nd); j++) {
+				fl_iter_next(&it, &d);
+				if (fl_near(d, n))
+					return fl_get_kth(l, i + j);
+			}
+			continue;
+		}
+		if (fl_near(nd->num, n)) {
+			return nd;
+		}
+	}
+	
+	return NULL;
+}
+
+
+
+/**
+ *  Compare 2 Flists. If they are equal, return 1. Otherwise return 0. O(N).
+ *  values are compared exactly (==), as the fingerprints are: lists whose
+ *  fingerprints differ are rejected in O(1), or in O(N) after a change away
+ *  from the ends invalidated the order-sensitive one.
+ * 
+ * @jamesdevftw
+*/
+int fl_equals(flist l, flist m)
+{
+	/* rewrote some of the edge-case/early disqualification
+	 * code (len check, head = sentinel same as head = NULL, etc.
+	 * @nolan-h-hamilton
+	*/
+	if (l == NULL) 
+		return m == NULL;
+	
+	if (m == NULL)
+		return l == NULL;
+	
+	/*
+	 * a cheap reject before the fingerprints: the sums of equal lists can
+	 * still differ by rounding when accumulated in a different order
+	 */
+	if (l->len != m->len)
+		return 0;
+	double mag = sqrt(l->sumsq * l->len) + sqrt(m->sumsq * m->len);
+	if (fabs(l->sum - m->sum) > FL_EPSILON * mag)
+		return 0;
+	
+	if (l->len == 0 && m->len == 0)
+		return 1;
+
+	/* the fingerprints reject lists whose values differ at all */
+	fl_hash_refresh_(l);
+	fl_hash_refresh_(m);
+	if (l->hash != m->hash || l->mhash != m->mhash)
+		return 0;
+	
+	if (l->head == NULL) 
+		return m->head == NULL;
+	
+	if (m->head == NULL)
+		return l->head == NULL;
+
+	/* frozen segments are compared as decompressed streams */
+	if (l->segs > 0 || m->segs > 0) {
+		fl_iter_type il, im;
+		double a, b;
+		fl_iter_at(l, 0, &il);
+		fl_iter_at(m, 0, &im);
+		while (fl_iter_next(&il, &a) && fl_iter_next(&im, &b))
+			if (a != b)
+				return 0;
+		return 1;
+	}
+
+	/*
+	 * walk both lists element by element; runs (see fl_set_rle()) are
+	 * compared once for the length they overlap
+	 */
+        fl_node nd = l->head;
+        fl_node md = m->head;
+	int rem_l = fl_node_count(l, nd);
+	int rem_m = fl_node_count(m, md);
+	int left = l->len;
+	while (left > 0) {
+		if (fl_aff_(l, nd->num) != fl_aff_(m, md->num))
+			return 0;
+		int step = rem_l < rem_m ? rem_l : rem_m;
+		left -= step;
+		rem_l -= step;
+		rem_m -= step;
+		if (rem_l == 0) {
+			nd = fl_step_(l, nd);
+			rem_l = fl_node_count(l, nd);
+		}
+		if (rem_m == 0) {
+			md = fl_step_(m, md);
+			rem_m = fl_node_count(m, md);
+		}
+	}
+	return 1;
+}
+
+
+/*
+ * nonzero, after printing why, if `l` cannot take a node that is intrusive
+ * (`intrusive` != 0) or allocated by flist: a non-empty flist holds nodes of
+ * one kind only, so that fl_free_node_() knows whether to free them. an empty
+ * flist takes either kind.
+ */
+static int fl_mixed_(flist l, int intrusive, const char * fn)
+{
+	if (l->len == 0)
+		l->intrusive = 0;
+	if (l->len == 0 || l->intrusive == intrusive)
+		return 0;
+	printf("\n%s(): flist holds %s nodes, which cannot be mixed with %s ones\n", fn,
+	       l->intrusive ? "intrusive" : "allocated", l->intrusive ? "allocated" : "intrusive");
+	return 1;
+}
+
+
+/**
+ * append to flist in O(1) time. an flist holding intrusive nodes (see
+ * fl_link_tail()) is left unchanged.
+ *
+ * @nolan-h-hamilton
+*/
+flist fl_append(flist l, double n)
+{
+	if (l == NULL) {
+		printf("\nfl_append(): flist `l` does not exist...returning NULL\n");
+	        return NULL;
+	}
+	if (fl_mixed_(l, 0, "fl_append"))
+		return l;
+	if (l->rev) {
+		/* the tail of a reversed flist is the head of the flipped one */
+		fl_flip_(l);
+		fl_push(l, n);
+		fl_flip_(l);
+		return l;
+	}
+	/* store the preimage under a pending transform rather than folding it in O(N) */
+	double s = fl_aff_store_(l, &n);
+	fl_log_append_(l, n);
+	fl_hash_end_(l, n, 1, 0);
+
+	/* in run-length mode, extend the tail run if `n` repeats it */
+	if (l->rle && l->len > 0 && !fl_is_seg_(l, l->tail) && fl_same_bits_(l->tail->num, s)) {
+		((fl_run) l->tail)->count++;
+		return fl_update_measures_(l, n, s, 1);
+	}
+	
+        fl_node nd = fl_new_node_(l, s);
+        if (l->head == NULL || l->len == 0) {
+                l->head = nd;
+                l->tail = nd;
+                nd->next = nd;
+                nd->prev = nd;
+		fl_sample_add_(l, nd);
+                return fl_update_measures_(l, n, s, 1);
+        }
+
+        nd->prev = l->tail;
+        nd->next = l->head;
+        l->tail->next = nd;
+        l->tail = nd;
+        l->head->prev = nd;
+	fl_sample_add_(l, nd);
+        return fl_update_measures_(l, n, s, 1);
+}
+
+
+/**
+ * append value `n` observed at time `t` in O(1). timestamps should be
+ * non-decreasing; an older `t` is treated as the latest timestamp.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_append_ts(flist l, double n, double t)
+{
+	if (l == NULL) {
+		printf("\nfl_append_ts(): flist `l` does not exist...returning NULL\n");
+	        return NULL;
+	}
+
+	fl_ew_advance_(l, t);
+	return fl_append(l, n);
+}
+
+
+/**
+ * find the node holding the 0-indexed k-th element and store the position of
+ * that element within the node's run in `off` (always 0 outside run-length
+ * mode). out-of-range `k` is clamped to head/tail.
+ *
+ * begins traversal at whichever of head, tail and the finger (the node found
+ * by the previous lookup, see `finger` in flist_type) is closest to `k`, so
+ * sequential positional access costs O(1) amortized per call. the node found
+ * becomes the new finger.
+ */
+static fl_node fl_locate_(flist l, int k, int *off)
+{
+	*off = 0;
+        if (l == NULL) {
+		printf("\nfl_get_kth(): flist `l` is NULL...returning NULL\n");
+                return NULL;
+        }
+        if (l->head == NULL || l->len == 0) {
+                return NULL;
+        }
+	if (k < 0)
+		return l->head;
+	if (k >= l->len) {
+		*off = fl_node_count(l, l->tail) - 1;
+		return l->tail;
+	}
+
+	/* i is the index of the first element of nd */
+	fl_node nd;
+	int i;
+	/* if index k is past midpoint, traverse list from back */
+	if (k > (l->len/2.0)) {
+		nd = l->tail;
+		i = l->len - fl_node_count(l, nd);
+	} else {
+		nd = l->head;
+		i = 0;
+	}
+	/* unless the finger left by the previous lookup is closer */
+	if (l->finger != NULL && abs(k - l->finger_idx) < abs(k - i)) {
+		nd = l->finger;
+		i = l->finger_idx;
+	}
+
+	while (i > k) {
+		fl_track_(l, nd, nd->prev);
+		nd = nd->prev;
+		i -= fl_node_count(l, nd);
+	}
+	while (i + fl_node_count(l, nd) <= k) {
+		i += fl_node_count(l, nd);
+		fl_track_(l, nd, nd->next);
+		nd = nd->next;
+	}
+	*off = k - i;
+	l->finger = nd;
+	l->finger_idx = i;
+	return nd;
+}
+
+
+/**
+ * returns the 0-indexed k-th element in O(N)
+ *
+ * begins traversal at head if `k` <= (l->len / 2)
+ * otherwise, begins traversal from tail. N/2 steps
+ * are performed in worst-case scenario.
+ *
+ * in run-length mode, the run containing the k-th element is returned and
+ * the walk is over runs rather than elements. a frozen segment containing the
+ * k-th element is thawed; use fl_iter_at() to read without thawing.
+ *
+ * after fl_reverse() the links are left as they were, so the returned node's
+ * `prev` leads to the next element and its `next` to the previous one.
+ *
+ * @nolan-h-hamilton
+ */
+fl_node fl_get_kth(flist l, int k)
+{
+	if (l != NULL && l->rev) {
+		fl_flip_(l);
+		fl_node nd = fl_get_kth(l, l->len - 1 - k);
+		fl_flip_(l);
+		return nd;
+	}
+	fl_affine_fold_(l);
+	int off;
+	fl_node nd = fl_locate_(l, k, &off);
+	if (nd != NULL && fl_is_seg_(l, nd)) {
+		fl_thaw_(l, nd);
+		nd = fl_locate_(l, k, &off);
+	}
+	return nd;
+}
+
+
+/**
+ * add node to beginning of flist. O(1).
+ *
+ * @nolan-h-hamilton @jamesdevftw
+*/
+
+flist fl_push(flist l, double n)
+{
+	if (l == NULL) {
+		printf("\nfl_push(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	if (fl_mixed_(l, 0, "fl_push"))
+		return l;
+	if (l->rev) {
+		fl_flip_(l);
+		fl_append(l, n);
+		fl_flip_(l);
+		return l;
+	}
+        if (l->head == NULL || l->len == 0) {
+                fl_append(l, n);
+                return l;
+        }
+	double s = fl_aff_store_(l, &n);
+	fl_touch_(l);
+	fl_hash_end_(l, n, 1, 1);
+	/* every element but the head run's first moves up one index */
+	if (l->finger != NULL)
+		l->finger_idx++;
+	/* in run-length mode, extend the head run if `n` repeats it */
+	if (l->rle && !fl_is_seg_(l, l->head) && fl_same_bits_(l->head->num, s)) {
+		((fl_run) l->head)->count++;
+		if (l->finger == l->head)
+			l->finger_idx = 0;
+		return fl_update_measures_(l, n, s, 1);
+	}
+        fl_node new = fl_new_node_(l, s);
+        new->prev = l->tail;
+        new->next = l->head;
+        l->tail->next = new;
+        l->head->prev = new;
+        l->head = new;
+	fl_sample_add_(l, new);
+        return fl_update_measures_(l, n, s, 1);
+}
+
+
+/**
+ * push value `n` observed at time `t` in O(1). see fl_append_ts()
+ *
+ * @nolan-h-hamilton
+*/
+flist fl_push_ts(flist l, double n, double t)
+{
+	if (l == NULL) {
+		printf("\nfl_push_ts(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+
+	fl_ew_advance_(l, t);
+	return fl_push(l, n);
+}
+
+
+/**
+ * remove head node and return head->num in O(1)
+ *
+ * allows for use of flist as a stack
+ *
+ * @nolan-h-hamilton
+*/
+double fl_pop(flist l)
+{
+        if (l == NULL || l->len == 0) {
+                printf("\nfl_pop(): cannot pop empty flist\n");
+		exit(1);
+        }
+	
+        if (l->head == NULL) {
+                printf("\nfl_pop(): cannot pop emtpy flist\n");
+                exit(1);
+        }
+	
+        double ret;
+	if (l->rev && l->len > 1) {
+		fl_flip_(l);
+		ret = fl_dequeue(l);
+		fl_flip_(l);
+		return ret;
+	}
+	fl_log_pop_(l);
+	if (fl_is_seg_(l, l->head))
+		fl_thaw_(l, l->head);
+	/* the value is read through a pending transform, which stays pending */
+	double s = l->head->num;
+	ret = fl_aff_(l, s);
+	fl_hash_end_(l, ret, 0, 1);
+	if (l->finger != NULL && l->finger != l->head)
+		l->finger_idx--;
+	/* in run-length mode, shorten the head run while it has more than one element */
+	if (l->ext && ((fl_run) l->head)->count > 1) {
+		((fl_run) l->head)->count--;
+		fl_update_measures_(l, ret, s, 0);
+		return ret;
+	}
+        if (l->len == 1) {
+		fl_sampler_remove(l->sampler, l->head);
+                l->head = l->tail;
+		l->finger = NULL;
+                printf("\nfl_pop(): flist is now NULL\n");
+		fl_update_measures_(l, ret, s, 0);
+                return ret;
+        }
+        fl_node head_cpy = l->head;
+        l->tail->next = l->head->next;
+        l->head->next->prev = l->tail;
+        l->head = l->head->next;
+	fl_update_measures_(l, ret, s, 0);
+        fl_free_node_(l, head_cpy);
+        return ret;
+}
+
+
+/**
+ * remove tail node from flist and return tail->num in O(1).
+ * 
+ * allows flists to be used as queues
+ *
+ * @nolan-h-hamilton
+*/
+double fl_dequeue(flist l)
+{
+        if (l == NULL || l->len == 0) {
+                printf("\nfl_dequeue(): cannot dequeue empty flist\n");
+                exit(1);
+        }
+
+	if (l->rev) {
+		fl_flip_(l);
+		double ret = fl_pop(l);
+		fl_flip_(l);
+		return ret;
+	}
+
+        if (l->len == 1) {
+                printf("\nfl_dequeue(): flist has length 1, calling fl_pop()\n");
+                return fl_pop(l);
+        }
+
+	fl_touch_(l);
+	if (fl_is_seg_(l, l->tail))
+		fl_thaw_(l, l->tail);
+        fl_node remove = l->tail;
+	double s = remove->num;
+        double ret = fl_aff_(l, s);
+	fl_hash_end_(l, ret, 0, 0);
+	if (l->ext && ((fl_run) remove)->count > 1) {
+		((fl_run) remove)->count--;
+		fl_update_measures_(l, ret, s, 0);
+		return ret;
+	}
+        remove->prev->next = l->head;
+        l->head->prev = remove->prev;
+        l->tail = remove->prev;
+        fl_free_node_(l, remove);
+        l = fl_update_measures_(l, ret, s, 0);
+        return ret;
+}
+
+
+/**
+ * remove element at index in O(N).
+ *
+ * uses fl_get_kth(), so at most N/2 steps
+ *
+ * @nolan-h-hamilton
+*/
+flist fl_remove_index(flist l, int index)
+{
+        if (l == NULL) {
+		printf("\nfl_remove_index(): flist `l` is NULL...returning NULL\n");
+                return NULL;
+        }
+	if (l->rev && index >= 0 && index < l->len) {
+		fl_flip_(l);
+		fl_remove_index(l, l->len - 1 - index);
+		fl_flip_(l);
+		return l;
+	}
+	fl_unreverse_(l);
+	fl_affine_fold_(l);
+
+        if (index > l->len) {
+                printf("\nfl_remove_index(): index does not exist\n");
+                return NULL;
+        }
+
+        if (index == 0) {
+                fl_pop(l);
+                return l;
+        }
+
+        if (index == l->len - 1) {
+                fl_dequeue(l);
+                return l;
+        }
+
+	fl_touch_(l);
+        fl_node remove = fl_get_kth(l, index);
+	if (l->ext && ((fl_run) remove)->count > 1) {
+		((fl_run) remove)->count--;
+		return fl_update_measures(l, remove->num, 0);
+	}
+        remove->prev->next = remove->next;
+        remove->next->prev = remove->prev;
+	/* the following node now starts at `index`: keep it as the finger */
+	l->finger = remove->next;
+	l->finger_idx = index;
+	l = fl_update_measures(l, remove->num, 0);
+        fl_free_node_(l, remove);
+	return l;
+}
+
+/**
+ * remove element in flist that has value `n`. removes the first element
+ * with value `n` only. runtime is O(N).
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_remove(flist l, double n)
+{
+	if (l == NULL) {
+		printf("\nfl_remove(): flist if NULL...returning NULL\n");
+		return NULL;
+	}
+	
+	int index = 0;
+	fl_iter_type it;
+	double d;
+	fl_iter_at(l, 0, &it);
+	while (fl_iter_next(&it, &d)) {
+		if (fl_near(n, d)) {
+			return fl_remove_index(l, index);
+		}
+		index++;
+	}
+
+	printf("\nfl_remove(): key not found in flist...\n");
+	return l;
+}
+
+
+/*
+ * evaluate `pred` once on every element of segment `nd`, recording the
+ * results in `dec`. nonzero if some element matched.
+ */
+static int fl_seg_matches_(flist l, fl_node nd, int (*pred)(double, void *), void * ctx,
+			   char * dec)
+{
+	fl_iter_type it;
+	fl_seg_iter_(l, nd, &it, 0);
+
+	double d;
+	int any = 0;
+	while (it.left > 0 && it.nd == nd) {
+		fl_iter_next(&it, &d);
+		*dec = pred(d, ctx) != 0;
+		any |= *dec++;
+	}
+	return any;
+}
+
+
+/**
+ * remove every element for which `pred(value, ctx)` is nonzero in a single
+ * O(N) pass and return the number of elements removed. matching nodes are
+ * unlinked and freed as the pass goes and len, sum, sumsq and the derived
+ * measures are adjusted once at the end instead of once per element.
+ *
+ * `pred` is called exactly once per node, in list order; in run-length mode
+ * that is once per run, so it should depend on the value only. the elements
+ * of a frozen segment are each tested once and the segment is thawed only if
+ * one of them matched.
+ *
+ * @nolan-h-hamilton
+ */
+int fl_remove_if(flist l, int (*pred)(double, void *), void * ctx)
+{
+	if (l == NULL) {
+		printf("\nfl_remove_if(): flist `l` is NULL...returning 0\n");
+		return 0;
+	}
+	fl_affine_fold_(l);
+	fl_unreverse_(l);
+	if (l->len == 0)
+		return 0;
+
+	/*
+	 * with frozen segments, decide every element before thawing so that the
+	 * thawed copies are not tested again. dec[i] holds the result for the
+	 * node starting at element i.
+	 */
+	fl_node nd = l->head;
+	char * dec = NULL;
+	if (l->segs > 0) {
+		dec = malloc(l->len);
+		if (dec == NULL) {
+			printf("\nfl_remove_if(): malloc failed...returning 0\n");
+			return 0;
+		}
+		for (int i = 0; i < l->len; ) {
+			/* a thawed segment is replaced in place: skip its copies */
+			fl_node nxt = nd->next;
+			int c = fl_node_count(l, nd);
+			if (!fl_is_seg_(l, nd))
+				dec[i] = pred(nd->num, ctx) != 0;
+			else if (fl_seg_matches_(l, nd, pred, ctx, dec + i))
+				fl_thaw_(l, nd);
+			i += c;
+			nd = nxt;
+		}
+		nd = l->head;
+	}
+
+	/* relink the surviving nodes into a chain keep_head..keep_tail */
+	fl_node keep_head = NULL;
+	fl_node keep_tail = NULL;
+	int removed = 0;
+	fl_moments_type gone = fl_moments_of(0, 0);
+	for (int i = 0; i < l->len; ) {
+		fl_node nxt = nd->next;
+		int c = fl_node_count(l, nd);
+		int hit = fl_is_seg_(l, nd) ? 0 : dec != NULL ? dec[i] : pred(nd->num, ctx);
+		i += c;
+		if (hit) {
+			fl_moments_type run = fl_moments_of(nd->num, c);
+			removed += c;
+			fl_moments_merge(&gone, &run, 1);
+			l->mhash -= c * fl_mhash_term_(nd->num);
+			if (l->sketch != NULL)
+				fl_sketch_add(l->sketch, nd->num, -c);
+			fl_free_node_(l, nd);
+		} else if (l->rle && keep_tail != NULL && !fl_is_seg_(l, keep_tail)
+			   && !fl_is_seg_(l, nd) && fl_same_bits_(keep_tail->num, nd->num)) {
+			/* runs that were separated by removed elements */
+			((fl_run) keep_tail)->count += c;
+			fl_free_node_(l, nd);
+		} else {
+			if (keep_tail != NULL)
+				keep_tail->next = nd;
+			else
+				keep_head = nd;
+			nd->prev = keep_tail;
+			keep_tail = nd;
+		}
+		nd = nxt;
+	}
+
+	/* the loop relinked every node: close the ring even if nothing matched */
+	l->head = keep_head;
+	l->tail = keep_tail;
+	if (keep_head != NULL) {
+		keep_head->prev = keep_tail;
+		keep_tail->next = keep_head;
+	}
+	free(dec);
+	if (removed == 0)
+		return 0;
+	fl_touch_(l);
+	l->hash_ok = 0;
+	/* indexes after the first removal have shifted */
+	l->finger = NULL;
+	fl_moments_type g = fl_mom_get_(l);
+	fl_moments_merge(&g, &gone, 0);
+	fl_mom_set_(l, &g);
+	return removed;
+}
+
+
+static int fl_near_pred_(double d, void * ctx)
+{
+	return fl_near(d, *(double *) ctx);
+}
+
+
+/**
+ * remove every element fl_near() `n` in a single O(N) pass, see
+ * fl_remove_if(). returns the number of elements removed.
+ *
+ * @nolan-h-hamilton
+ */
+int fl_remove_all(flist l, double n)
+{
+	return fl_remove_if(l, fl_near_pred_, &n);
+}
+
+/*
+ * link a node for `n` so that it becomes element `index`, 0 < `index` < l->len,
+ * of a flist walked through `next`
+ */
+static void fl_insert_at_(flist l, int index, double n)
+{
+	fl_touch_(l);
+	int off;
+        fl_node p = fl_locate_(l, index - 1, &off);
+	if (fl_is_seg_(l, p)) {
+		fl_thaw_(l, p);
+		p = fl_locate_(l, index - 1, &off);
+	}
+	if (l->rle) {
+		/* join the run `n` lands in or next to, if it repeats it */
+		if (fl_same_bits_(p->num, n)) {
+			((fl_run) p)->count++;
+			fl_update_measures(l, n, 1);
+			return;
+		}
+		if (off == ((fl_run) p)->count - 1 && !fl_is_seg_(l, p->next)
+		    && fl_same_bits_(p->next->num, n)) {
+			((fl_run) p->next)->count++;
+			fl_update_measures(l, n, 1);
+			return;
+		}
+		/* `n` lands inside run `p`: split it and link the tail half after `p` */
+		if (off < ((fl_run) p)->count - 1) {
+			fl_node rest = fl_new_node_(l, p->num);
+			((fl_run) rest)->count = ((fl_run) p)->count - off - 1;
+			((fl_run) p)->count = off + 1;
+			rest->prev = p;
+			rest->next = p->next;
+			p->next->prev = rest;
+			p->next = rest;
+			if (p == l->tail)
+				l->tail = rest;
+		}
+	}
+        fl_node new = fl_new_node_(l, n);
+        fl_node p_next_cpy = p->next;
+
+        new->prev = p;
+        p->next = new;
+
+        new->next = p_next_cpy;
+        p_next_cpy->prev = new;
+	fl_sample_add_(l, new);
+	fl_update_measures(l, n, 1);
+}
+
+
+/**
+ * inserts element with value `n` so that it becomes the element at `index`
+ * in O(N). index 0 pushes and index len - 1 appends, so the new element then
+ * ends up last rather than at `index`; index len is rejected.
+ *
+ * the walk starts at the nearer end, so at most N/2 steps
+ *
+ * @nolan-h-hamilton
+*/
+flist fl_insert_index(flist l, int index, double n)
+{
+        if (l == NULL) {
+		printf("\nfl_insert_index(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+        }
+	if (fl_mixed_(l, 0, "fl_insert_index"))
+		return l;
+	fl_affine_fold_(l);
+	
+	if (index >= l->len && index > 0) {
+		printf("\nfl_insert_index(): index does not exist\n");
+		return l;
+	}
+	
+
+        if (index == 0) {
+                fl_push(l, n);
+                return l;
+        }
+
+        if (index == l->len - 1) {
+                fl_append(l, n);
+                return l;
         }
+
+	if (l->rev) {
+		/* the element lands at the mirrored index of the flipped list */
+		fl_flip_(l);
+		fl_insert_at_(l, l->len - index, n);
+		fl_flip_(l);
+		return l;
+	}
+	fl_insert_at_(l, index, n);
+	return l;
+}
+
+
+/**
+ * insert new node into sorted list in correct index in O(N).
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_insert(flist l, double n) {
+	if (l == NULL) {
+		printf("\nfl_insert(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	if (fl_mixed_(l, 0, "fl_insert"))
+		return l;
+	fl_affine_fold_(l);
+
+	if (l->len == 0) {
+		fl_append(l,n);
+		return l;
+	}
+
+	if (l->rev) {
+		/* find the place of `n` reading in order, then link it in on the flipped list */
+		fl_iter_type it;
+		double prev, d;
+		int k;
+		fl_iter_at(l, 0, &it);
+		fl_iter_next(&it, &prev);
+		if (n < prev) {
+			fl_push(l, n);
+			return l;
+		}
+		for (k = 1; fl_iter_next(&it, &d); k++, prev = d)
+			if ((n > prev || fl_near(n, prev)) && (n < d || fl_near(n, d)))
+				break;
+		if (k == l->len) {
+			fl_append(l, n);
+			return l;
+		}
+		fl_flip_(l);
+		fl_insert_at_(l, l->len - k, n);
+		fl_flip_(l);
+		return l;
+	}
+
+	/* segments are thawed as the walk reaches them */
+	if (fl_is_seg_(l, l->head))
+		fl_thaw_(l, l->head);
+	if (fl_is_seg_(l, l->tail))
+		fl_thaw_(l, l->tail);
+
+	if (n < l->head->num) {
+		
+	        fl_push(l,n);
+		return l;
+	}
+
+	if (n > l->tail->num) {
+		fl_append(l, n);
+		return l;
+	}
 	
-        double ret;
-        if (l->len == 1) {
-                ret = l->head->num;
-                l->head = l->tail;
-                printf("\nfl_pop(): flist is now NULL\n");
-		fl_update_measures(l, ret, 0);
-                return ret;
+	fl_touch_(l);
+	/* the element lands before an unknown number of others: drop the finger */
+	l->finger = NULL;
+	fl_node iter = l->head->next;
+	while (iter != l->head) {
+		if (fl_is_seg_(l, iter))
+			iter = fl_thaw_(l, iter);
+		if ((n > iter->prev->num || fl_near(n, iter->prev->num))
+		     && (n < iter->num || fl_near(n, iter->num))) {
+			if (l->rle && fl_same_bits_(n, iter->prev->num)) {
+				((fl_run) iter->prev)->count++;
+				return fl_update_measures(l, n, 1);
+			}
+			if (l->rle && fl_same_bits_(n, iter->num)) {
+				((fl_run) iter)->count++;
+				return fl_update_measures(l, n, 1);
+			}
+			fl_node new = fl_new_node_(l, n);
+			iter->prev->next = new;
+			new-> prev = iter->prev;
+			new->next = iter;
+			iter->prev = new;
+			fl_sample_add_(l, new);
+			return fl_update_measures(l, n, 1);
+		}
+		iter = iter->next;
+	}
+	fl_append(l, n);
+	return l;
+	
+}
+
+
+/**
+ *  create a new flist containing elements of `l` at indexes a::b in O(N).
+ *
+ * @nolan-h-hamilton
+*/
+flist fl_subflist(flist l, int a, int b)
+{
+	if (l == NULL) {
+		printf("\nfl_subflist(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	
+	if (!(a < b && b < l->len)) {
+		printf("\nfl_subflist(): indices out of range...returning NULL\n");
+		return NULL;
+	}
+		
+        flist sub = fl_make_flist();
+	fl_set_rle(sub, l->rle);
+	fl_iter_type it;
+	double d;
+	fl_iter_at(l, a, &it);
+	int steps = (b - a) + 1;
+	int i = 0;
+        while (i++ < steps && fl_iter_next(&it, &d)) {
+		fl_append(sub, d);
+        }
+        return sub;
+}
+
+
+/**
+ * reverses flist in O(1) time
+ *
+ * note: swaps head and tail and sets `l->rev`, so that the ring is walked
+ * through `prev`; frozen segments are then read from their end. reads,
+ * searches, comparisons and insertions honor the flag. only the O(N)
+ * restructuring calls (fl_set_rle(), fl_freeze(), fl_remove_if(), fl_sort(),
+ * fl_compact()) swap the links of every node back and clear it.
+ *
+ * @nolan-h-hamilton
+*/
+flist fl_reverse(flist l)
+{
+        if (l == NULL || l->len <= 1) {
+                return l;
+        }
+
+	fl_touch_(l);
+	fl_flip_(l);
+        return l;
+}
+
+
+/**
+ * rotate `l` so that the element at index `k` (taken modulo len, so negative
+ * `k` rotates the other way) becomes the head. only head and tail move, in
+ * O(min(k, len - k)) steps; the measures are unchanged and no node is
+ * allocated or freed, except that a run or segment holding both the new head
+ * and its predecessor is split.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_rotate(flist l, int k)
+{
+	if (l == NULL) {
+		printf("\nfl_rotate(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	if (l->len == 0)
+		return l;
+	k %= l->len;
+	if (k < 0)
+		k += l->len;
+	if (k == 0)
+		return l;
+	if (l->rev) {
+		/* rotating forward is rotating the flipped list backward */
+		fl_flip_(l);
+		fl_rotate(l, l->len - k);
+		fl_flip_(l);
+		return l;
+	}
+
+	fl_touch_(l);
+	l->hash_ok = 0;
+	fl_split_before_(l, k);
+	int off;
+	fl_node nd = fl_locate_(l, k, &off);
+	l->head = nd;
+	l->tail = nd->prev;
+	l->finger = nd;
+	l->finger_idx = 0;
+	return l;
+}
+
+
+/**
+ * delete all nodes in `l` in O(N)
+ *
+ * @nolan-h-hamilton
+*/
+void fl_destroy(flist l)
+{
+	if (l == NULL) {
+		printf("\nfl_destroy(): flist `l` does not exist...\n");
+		return;
+	}
+	
+	fl_sampler_destroy(l->sampler);
+	l->sampler = NULL;
+	fl_node nd = l -> head;
+	while (nd != l -> tail) {
+		fl_node cpy = fl_step_(l, nd);
+		fl_free_node_(l, nd);
+		nd = cpy;
+	}
+	if (nd != NULL)
+		fl_free_node_(l, nd);
+	fl_sketch_destroy(l->sketch);
+	l->sketch = NULL;
+	fl_log_drop_(l);
+}
+
+
+/* annotate a printed node with its run length or segment size */
+static void fl_print_count_(flist l, fl_node nd)
+{
+	if (fl_is_seg_(l, nd))
+		printf(" frozen x%d (%zu bytes)", fl_node_count(l, nd), ((fl_seg) nd)->nbytes);
+	else if (fl_node_count(l, nd) > 1)
+		printf(" x%d", fl_node_count(l, nd));
+}
+
+
+/*
+ * print node `nd` of `l` like fl_print_node(), its value read through a
+ * pending transform and its neighbours in element order
+ */
+static void fl_print_elem_(flist l, fl_node nd)
+{
+	printf("\n%p: (%p, %.7f, %p)", nd, fl_back_(l, nd), fl_aff_(l, nd->num), fl_step_(l, nd));
+	fl_print_count_(l, nd);
+}
+
+
+/**
+ * print nodes in `l` with format: "node_addr: (*prev, num, *next)". O(N).
+ *
+ * @nolan-h-hamilton
+*/
+
+void fl_print(flist l)
+{
+	if (l == NULL) {
+		printf("\nfl_print(): flist `l` does not exist...\n");
+		return;
+	}
+	
+        if (l->head == NULL && l != NULL) {
+                printf("\nfl_print(): empty flist\n");
+                return;
+        }
+
+        fl_node nd = l->head;
+        while (nd != l->tail) {
+		fl_print_elem_(l, nd);
+                nd = fl_step_(l, nd);
+        }
+	fl_print_elem_(l, nd);
+        printf("\n");
+
+}
+
+
+/**
+ * print single node of flist in format: "node_ptr: (*prev, num, *next)"
+ *
+ * @nolan-h-hamilton
+*/
+void fl_print_node(fl_node nd)
+{
+        if (nd == NULL) {
+                printf("\fl_print_node(): node is NULL\n");
+		return;
+        }
+        int has_next = 0;
+        int has_prev = 0;
+        double n = nd->num;
+        if (nd->next != NULL) {
+                has_next = 1;
+        }
+
+        if (nd->prev != NULL) {
+                has_prev = 1;
+        }
+
+        if (has_next && has_prev) {
+                printf("\n%p: (%p, %.7f, %p)", nd, nd->prev, nd->num, nd->next);
+                return;
+        }
+
+        if (has_prev && !(has_next)) {
+                printf("\n%p: (%p, %.7f, NULL)", nd, nd->prev, nd->num);
+                return;
+        }
+        if (has_next && !(has_prev)) {
+                printf("\n%p: (NULL, %.7f, %p)", nd, nd->num, nd->next);
+                return;
+        }
+        else {
+                printf("\n%p: (NULL, %.7f, NULL)", nd, nd->num);
+        }
+        return;
+}
+
+
+/**
+ * print basic info of flist
+ *
+ * @nolan-h-hamilton
+*/
+void fl_state(flist l)
+{
+        printf("\n\n");
+        if (l == NULL) {
+                printf("\nfl_state(): flist is null\n");
+		return;
+        }
+
+        printf("sum: %.3f\n", l->sum);
+        printf("mean: %.3f\n", l->mean);
+	printf("(est.) variance: %.3f\n", l->variance);
+	printf("(est.) standard deviation: %.3f\n", l->std_dev);
+	printf("skewness: %.3f\n", l->skewness);
+	printf("excess kurtosis: %.3f\n", l->kurtosis);
+	printf("length: %d\n", l->len);
+	if (l->decay > 0 || l->decay_tau > 0) {
+		printf("ew mean: %.3f\n", l->ew_mean);
+		printf("ew variance: %.3f\n", l->ew_variance);
+	}
+        if (l->head != NULL) {
+                printf("head: (%p, %.3f)\n", l->head, fl_aff_(l, l->head->num));
+                if (l->head->prev != NULL) {
+                        fl_node hp = fl_back_(l, l->head);
+                        printf("head prev: (%p, %.3f)\n", hp, fl_aff_(l, hp->num));
+                } else {
+                        printf("head -> prev is NULL but head != NULL\n");
+                }
+        }
+
+        if (l->tail != NULL) {
+                printf("tail: (%p, %.3f)\n", l->tail, fl_aff_(l, l->tail->num));
+                if (l->tail->next != NULL) {
+                        fl_node tn = fl_step_(l, l->tail);
+                        printf("tail next: (%p, %.3f)\n", tn, fl_aff_(l, tn->num));
+                } else {
+                        printf("tail -> next is NULL but tail != NULL\n");
+                }
+        } else {
+                printf("fl_state(): flist is empty and has not been initialized\n");
+                return;
         }
-        fl_node head_cpy = l->head;
-	ret = head_cpy->num;
-        l->tail->next = l->head->next;
-        l->head->next->prev = l->tail;
-        l->head = l->head->next;
-	fl_update_measures(l, ret, 0);
-        free(head_cpy);
-        return ret;
+
+        printf("empty?: %d\n", l->len==0);
+        printf("flist elements:");
+        fl_print(l);
+}
+
+
+/* append the elements of `src` to `dst` in order */
+static void fl_copy_into_(flist dst, flist src)
+{
+	fl_iter_type it;
+	double d;
+	fl_iter_at(src, 0, &it);
+	while (fl_iter_next(&it, &d))
+		fl_append(dst, d);
+}
+
+
+/* give `dst`, holding a copy of the elements of `src`, a copy of its sketch */
+static void fl_copy_sketch_(flist dst, flist src)
+{
+	if (src->sketch == NULL)
+		return;
+	/* the sketch of `src` still holds its values from before a pending transform */
+	if (src->aff_a == 1 && src->aff_b == 0)
+		dst->sketch = fl_sketch_copy(src->sketch);
+	else
+		fl_enable_sketch(dst, src->sketch->alpha, src->sketch->max_bins);
 }
 
 
 /**
- * remove tail node from flist and return tail->num in O(1).
- * 
- * allows flists to be used as queues
+ * Function that takes a flist and returns a complete copy of that flist using local references
  *
- * @nolan-h-hamilton
-*/
-double fl_dequeue(flist l)
+ * @jamesdevftw
+ */
+flist fl_copy(flist currentFlist)
 {
-        if (l == NULL || l->len == 0) {
-                printf("\nfl_dequeue(): cannot dequeue empty flist\n");
-                exit(1);
-        }
+	if (currentFlist == NULL || currentFlist->head == NULL) {
+		printf("\nfl_copy(): flist `currentFlist` is NULL...\n");
+		return NULL;
+	}
 
-        if (l->len == 1) {
-                printf("\nfl_dequeue(): flist has length 1, calling fl_pop()\n");
-                return fl_pop(l);
-        }
+        flist newFlist = fl_make_flist();
+	if (currentFlist->len == 0)
+		return newFlist;
+	fl_set_rle(newFlist, currentFlist->rle);
+	fl_copy_into_(newFlist, currentFlist);
+	fl_copy_sketch_(newFlist, currentFlist);
+        return newFlist;
+}
 
-        fl_node remove = l->tail;
-        double ret = remove->num;
-        remove->prev->next = l->head;
-        l->head->prev = remove->prev;
-        l->tail = remove->prev;
-        free(remove);
-        l = fl_update_measures(l, ret, 0);
-        return ret;
+
+/**
+ * Function that creates a copy of two lists and combines the copies together.
+ * Function returns the combined copies.
+ *
+ * if both flists carry a quantile sketch with the same accuracy, the sketches
+ * are merged in O(sketch size) rather than re-fed element by element.
+ * @jamesdevftw
+ */
+flist fl_combine(flist l, flist m)
+{
+	if (l == NULL && m == NULL) {
+		printf("\nfl_combine(): both flists empty, returning NULL\n");
+		return NULL;
+	}
+	
+	if (l == NULL && m != NULL)
+		return m;
+	if (m == NULL && l != NULL)
+		return l;
+	/* an flist emptied by fl_pop() keeps a stale head: there is no ring to join */
+	if (l->len == 0)
+		return m->len == 0 ? fl_make_flist() : fl_copy(m);
+	if (m->len == 0)
+		return fl_copy(l);
+        flist newL = fl_copy(l);
+	/* copy `m` in the node layout of `l` so the two rings can be joined */
+        flist newM = fl_make_flist();
+	fl_set_rle(newM, l->rle);
+	fl_copy_into_(newM, m);
+	fl_copy_sketch_(newM, m);
+        
+        //Conncect the two flists
+        newL->tail->next = newM->head;
+        newM->tail->next = newL->head;
+	newM->head->prev = newL->tail;
+	newL->head->prev = newM->tail;
+	newL->tail = newM->tail;
+	/* the fingerprints of a concatenation follow from those of its parts */
+	newL->hash = (newL->hash + fl_mulmod_(newM->hash, newL->hash_pow)) % FL_HASH_P;
+	newL->hash_rev = (newM->hash_rev + fl_mulmod_(newL->hash_rev, newM->hash_pow)) % FL_HASH_P;
+	newL->hash_pow = fl_mulmod_(newL->hash_pow, newM->hash_pow);
+	newL->hash_ok = newL->hash_ok && newM->hash_ok;
+	newL->mhash += newM->mhash;
+	newL->mhash_ok = newL->mhash_ok && newM->mhash_ok;
+
+        //Recalculate measures: length, sums, mean, variance and std_dev
+	fl_moments_type g = fl_mom_get_(newL);
+	fl_moments_type h = fl_mom_get_(newM);
+	fl_moments_merge(&g, &h, 1);
+	fl_mom_set_(newL, &g);
+
+	//Quantile sketch, kept only if both inputs have one
+	if (newL->sketch != NULL && (newM->sketch == NULL
+				     || !fl_sketch_merge(newL->sketch, newM->sketch))) {
+		fl_sketch_destroy(newL->sketch);
+		newL->sketch = NULL;
+	}
+	fl_sketch_destroy(newM->sketch);
+	free(newM);
+
+        return newL;
 }
 
 
 /**
- * remove element at index in O(N).
+ * convert flist to an array of double
  *
- * uses fl_get_kth(), so at most N/2 steps
+ * @nolan-h-hamilton
+ */
+double * fl_to_arr(flist l)
+{
+	if (l == NULL || l->head == NULL) return NULL;
+	
+	double * arr = (double *) malloc(sizeof(double)*l->len);
+	
+	if (arr == NULL) {
+		printf("\nfl_to_arr(): memory allocation for array failed\n");
+		return NULL;
+	}
+	
+	fl_iter_type it;
+	fl_iter_at(l, 0, &it);
+	for (int i = 0; i < l->len; i++)
+		fl_iter_next(&it, &arr[i]);
+	return arr;
+}
+
+
+/**
+ * copy vallues from `arr` to `l`
+ *
+ * note: will cast array values to double
  *
  * @nolan-h-hamilton
-*/
-flist fl_remove_index(flist l, int index)
+ */
+void fl_from_arr(flist l, void * arr, int arr_len)
 {
-        if (l == NULL) {
-		printf("\nfl_remove_index(): flist `l` is NULL...returning NULL\n");
-                return NULL;
-        }
+	if (l == NULL) {
+		printf("\nfl_from_arr(): flist is null...return\n");
+		return;
+	}
+	if (arr == NULL) {
+		printf("\nfl_from_arr(): array is null...return\n");
+		return;
+	}
+	if (fl_mixed_(l, 0, "fl_from_arr"))
+		return;
+	double *darr = (double *) arr;
+	for (int i = 0; i < arr_len; i++) {
+		l = fl_append(l, (double) darr[i]);
+	}
+}
 
-        if (index > l->len) {
-                printf("\nfl_remove_index(): index does not exist\n");
-                return NULL;
-        }
 
-        if (index == 0) {
-                fl_pop(l);
-                return l;
-        }
 
-        if (index == l->len - 1) {
-                fl_dequeue(l);
-                return l;
-        }
 
-        fl_node remove = fl_get_kth(l, index);
-	double remove_num = remove->num;
-        remove->prev->next = remove->next;
-        remove->next->prev = remove->prev;
-	l = fl_update_measures(l, remove->num, 0);
-        free(remove);
+/* used for fl_sort() */
+fl_node fl_merge_(fl_node A, fl_node B) {
+	if (A == NULL) return B;
+	if (B == NULL) return A;
+	fl_node C = NULL;
+	fl_node last = NULL;
+	while (A != NULL && B != NULL) {
+		if (A->num  < B->num) {
+			if (C == NULL) {
+				C = A;
+			}
+			else {
+				last->next = A;
+			}
+			last = A;
+			last->prev = last;
+			A = A->next;
+		}
+		else {
+			if (C == NULL) {
+				C = B;
+			}
+			else {
+				last->next = B;
+			}
+			last = B;
+			last->prev = last;
+			B = B->next;
+		}
+	}
+	if (A == NULL) {
+		last->next = B;
+		B->prev = last;
+	}
+	else {
+		last -> next = A;
+		A->prev = last;
+	}
+	return C;
+}
+
+
+/* used for fl_sort() */
+fl_node fl_split_(fl_node head) 
+{ 
+    fl_node fast = head, slow = head; 
+    while (fast->next && fast->next->next) 
+    { 
+        fast = fast->next->next; 
+        slow = slow->next; 
+    } 
+    fl_node temp = slow->next; 
+    slow->next = NULL; 
+    return temp; 
+}
+
+
+/* used for fl_sort() */
+fl_node fl_merge_sort_(fl_node head) {
+
+	if (head == NULL || head->next == NULL) {
+		return head;
+	}
+	fl_node second = fl_split_(head);
+
+	head = fl_merge_sort_(head); 
+	second = fl_merge_sort_(second); 
+	return fl_merge_(head,second); 
+}
+
+
+/**
+ * sort nodes in flist in O(N log N)
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_sort(flist l) {
+	if (l == NULL || l->len == 0)
+		return l;
+	fl_thaw_all(l);
+	fl_unreverse_(l);
+	fl_touch_(l);
+	l->hash_ok = 0;
+	l->finger = NULL;
+	fl_node hd_cpy = l->head;
+	hd_cpy->prev->next = NULL;
+	hd_cpy = fl_merge_sort_(hd_cpy);
+	l->head = hd_cpy;
+	l->head->prev = NULL;
+	fl_node iter = l->head;
+	while (iter->next != NULL) {
+		/* in run-length mode, equal runs end up adjacent: coalesce them */
+		if (l->rle && fl_same_bits_(iter->num, iter->next->num)) {
+			fl_node dup = iter->next;
+			((fl_run) iter)->count += ((fl_run) dup)->count;
+			iter->next = dup->next;
+			fl_free_node_(l, dup);
+			continue;
+		}
+		iter->next->prev = iter;
+		iter = iter->next;
+	}
+	l->tail = iter;
+	l->tail->next = l->head;
+	l->head->prev = l->tail;
+
 	return l;
 }
+/**
+ * determine if values in flist are sorted in O(N)
+ *
+ * @nolan-h-hamilton
+ */
+int fl_is_sorted(flist l) {
+	if (l == NULL) {
+		printf("\nfl_is_sorted(): flist is NULL, returning -1\n");
+		return -1;
+	}
+
+	if (l->len == 0) return 1;
+	
+	fl_iter_type it;
+	double prev, d;
+	fl_iter_at(l, 0, &it);
+	fl_iter_next(&it, &prev);
+	while (fl_iter_next(&it, &d)) {
+		if (d < prev) {
+			return 0;
+		}
+		prev = d;
+	}
+
+	return 1;
+}
+
+
+/* set operations on sorted flists, see fl_set_op_() */
+enum { FL_UNION_, FL_INTERSECTION_, FL_DIFFERENCE_ };
+
 
 /**
- * remove element in flist that has value `n`. removes the first element
- * with value `n` only. runtime is O(N).
- *
- * @nolan-h-hamilton
+ * walk sorted flists `l` and `m` in step and append to a new flist, in the
+ * layout of `l`, the elements selected by `op`. elements are equal if
+ * fl_near(); duplicates are treated as a multiset, like std::set_union() and
+ * friends. O(N + M).
  */
-flist fl_remove(flist l, double n)
+static flist fl_set_op_(flist l, flist m, int op, const char * name)
 {
-	if (l == NULL) {
-		printf("\nfl_remove(): flist if NULL...returning NULL\n");
+	if (l == NULL || m == NULL) {
+		printf("\n%s(): flist is NULL, returning NULL\n", name);
 		return NULL;
 	}
-	
-	int index = 0;
-	fl_node iter = l->head;
-	while (iter->next != l->head) {
-		fl_print_node(iter);
-		if (fl_near(n, iter->num)) {
-			return fl_remove_index(l, index);
+
+	flist out = fl_make_flist();
+	if (out == NULL)
+		return NULL;
+	fl_set_rle(out, l->rle);
+
+	fl_iter_type il, im;
+	double a, b;
+	fl_iter_at(l, 0, &il);
+	fl_iter_at(m, 0, &im);
+	int has_a = fl_iter_next(&il, &a);
+	int has_b = fl_iter_next(&im, &b);
+	while (has_a && has_b) {
+		if (fl_near(a, b)) {
+			if (op != FL_DIFFERENCE_)
+				fl_append(out, a);
+			has_a = fl_iter_next(&il, &a);
+			has_b = fl_iter_next(&im, &b);
+		} else if (a < b) {
+			if (op != FL_INTERSECTION_)
+				fl_append(out, a);
+			has_a = fl_iter_next(&il, &a);
+		} else {
+			if (op == FL_UNION_)
+				fl_append(out, b);
+			has_b = fl_iter_next(&im, &b);
 		}
-		index++;
-		iter = iter->next;
 	}
+	for (; has_a && op != FL_INTERSECTION_; has_a = fl_iter_next(&il, &a))
+		fl_append(out, a);
+	for (; has_b && op == FL_UNION_; has_b = fl_iter_next(&im, &b))
+		fl_append(out, b);
+	return out;
+}
 
-	if (fl_near(iter->num, n)) {
-		return fl_remove_index(l, index);
-	}
 
-	printf("\nfl_remove(): key not found in flist...\n");
-	return l;
+/**
+ * union of sorted flists `l` and `m` as a new sorted flist in O(N + M).
+ * an element occurring i times in `l` and j times in `m` occurs max(i, j)
+ * times in the result.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_union(flist l, flist m)
+{
+	return fl_set_op_(l, m, FL_UNION_, "fl_union");
 }
 
+
 /**
- * inserts element with value `n` after the provided index in O(N).
- *
- * uses fl_get_kth(), so at most N/2 steps
+ * intersection of sorted flists `l` and `m` as a new sorted flist in
+ * O(N + M), with min(i, j) copies of each common element
  *
  * @nolan-h-hamilton
-*/
-flist fl_insert_index(flist l, int index, double n)
+ */
+flist fl_intersection(flist l, flist m)
 {
-        if (l == NULL) {
-		printf("\nfl_insert_index(): flist `l` does not exist...returning NULL\n");
-		return NULL;
-        }
-	
-	if (index >= l->len && index > 0) {
-		printf("\nfl_insert_index(): index does not exist\n");
-		return l;
-	}
-	
+	return fl_set_op_(l, m, FL_INTERSECTION_, "fl_intersection");
+}
 
-        if (index == 0) {
-                fl_push(l, n);
-                return l;
-        }
 
-        if (index == l->len - 1) {
-                fl_append(l, n);
-                return l;
-        }
+/**
+ * elements of sorted flist `l` not in sorted flist `m`, as a new sorted
+ * flist in O(N + M). each element of `m` cancels at most one equal element
+ * of `l`.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_difference(flist l, flist m)
+{
+	return fl_set_op_(l, m, FL_DIFFERENCE_, "fl_difference");
+}
 
-        fl_node p = fl_get_kth(l, index - 1);
-        fl_node new = fl_make_node(n);
-        fl_node p_next_cpy = p->next;
 
-        new->prev = p;
-        p->next = new;
+/* min-heap entry of fl_merge_sorted(): current head value of input `src` */
+typedef struct {
+	double num;
+	int src;
+} fl_heap_entry_;
 
-        new->next = p_next_cpy;
-        p_next_cpy->prev = new;
-        return fl_update_measures(l, n, 1);;
+
+/* restore the heap property below position `i`; ties go to the lower `src` */
+static void fl_heap_down_(fl_heap_entry_ * h, int n, int i)
+{
+	for (;;) {
+		int min = i;
+		int c = 2*i + 1;
+		for (int j = c; j < c + 2 && j < n; j++) {
+			if (h[j].num < h[min].num
+			    || (h[j].num == h[min].num && h[j].src < h[min].src))
+				min = j;
+		}
+		if (min == i)
+			return;
+		fl_heap_entry_ tmp = h[i];
+		h[i] = h[min];
+		h[min] = tmp;
+		i = min;
+	}
 }
 
 
 /**
- * insert new node into sorted list in correct index in O(N).
+ * merge `k` sorted flists into a new sorted flist (in the layout of the
+ * first) in O(N log k) using a binary heap of the inputs' current elements.
+ * the inputs are left unchanged. len, sum and sumsq of the result are the
+ * totals of the inputs' fields rather than re-accumulated element by element,
+ * and the inputs' quantile sketches are merged if every input has one.
  *
  * @nolan-h-hamilton
  */
-flist fl_insert(flist l, double n) {
-	if (l == NULL) {
-		printf("\nfl_insert(): flist `l` does not exist...returning NULL\n");
+flist fl_merge_sorted(flist * lists, int k)
+{
+	if (lists == NULL || k <= 0) {
+		printf("\nfl_merge_sorted(): no flists given, returning NULL\n");
 		return NULL;
 	}
+	for (int i = 0; i < k; i++) {
+		if (lists[i] == NULL) {
+			printf("\nfl_merge_sorted(): flist %d is NULL, returning NULL\n", i);
+			return NULL;
+		}
+	}
 
-	if (l->len == 0) {
-		fl_append(l,n);
-		return l;
+	fl_heap_entry_ *h = (fl_heap_entry_ *) malloc(sizeof(fl_heap_entry_) * k);
+	fl_iter_type *its = (fl_iter_type *) malloc(sizeof(fl_iter_type) * k);
+	flist out = fl_make_flist();
+	if (h == NULL || its == NULL || out == NULL) {
+		printf("\nfl_merge_sorted(): memory allocation failed, returning NULL\n");
+		free(h);
+		free(its);
+		free(out);
+		return NULL;
 	}
+	fl_set_rle(out, lists[0]->rle);
 
-	if (n < l->head->num) {
-		
-	        fl_push(l,n);
-		return l;
+	int n = 0;
+	for (int i = 0; i < k; i++) {
+		fl_iter_at(lists[i], 0, &its[i]);
+		if (fl_iter_next(&its[i], &h[n].num))
+			h[n++].src = i;
 	}
+	for (int i = n/2 - 1; i >= 0; i--)
+		fl_heap_down_(h, n, i);
 
-	if (n > l->tail->num) {
-		fl_append(l, n);
-		return l;
+	while (n > 0) {
+		fl_append(out, h[0].num);
+		/* replace the root by the next element of its input, if any */
+		if (!fl_iter_next(&its[h[0].src], &h[0].num))
+			h[0] = h[--n];
+		fl_heap_down_(h, n, 0);
 	}
-	
-	fl_node iter = l->head->next;
-	while (iter != l->head) {
-		if ((n > iter->prev->num || fl_near(n, iter->prev->num))
-		     && (n < iter->num || fl_near(n, iter->num))) {
-			fl_node new = fl_make_node(n);
-			iter->prev->next = new;
-			new-> prev = iter->prev;
-			new->next = iter;
-			iter->prev = new;
-			return fl_update_measures(l, n, 1);
+	free(h);
+	free(its);
+
+	if (out->len > 0) {
+		fl_moments_type g = fl_moments_of(0, 0);
+		for (int i = 0; i < k; i++) {
+			fl_moments_type h = fl_mom_get_(lists[i]);
+			fl_moments_merge(&g, &h, 1);
 		}
-		iter = iter->next;
+		fl_mom_set_(out, &g);
 	}
-	fl_append(l, n);
-	return l;
-	
+
+	int sketched = 1;
+	for (int i = 0; i < k; i++)
+		sketched &= lists[i]->sketch != NULL;
+	if (sketched) {
+		out->sketch = fl_sketch_copy(lists[0]->sketch);
+		for (int i = 1; i < k && out->sketch != NULL; i++) {
+			if (!fl_sketch_merge(out->sketch, lists[i]->sketch)) {
+				fl_sketch_destroy(out->sketch);
+				out->sketch = NULL;
+			}
+		}
+	}
+	return out;
 }
 
 
 /**
- *  create a new flist containing elements of `l` at indexes a::b in O(N).
+ * take an immutable view of the elements and measures of `l`. flist keeps,
+ * once the first snapshot is taken, an append-only log of its elements in
+ * reference-counted blocks of FL_CHUNK_LEN values; a snapshot is a reference
+ * to the first block plus an offset and a copy of the measures, so it costs
+ * O(1) and later fl_append()/fl_pop() calls, which only add to or advance
+ * through the log, never copy or disturb it. any other modification drops the
+ * log (snapshots keep the blocks they reference) and the next snapshot
+ * rebuilds it in O(N). release with fl_snap_release().
  *
  * @nolan-h-hamilton
-*/
-flist fl_subflist(flist l, int a, int b)
+ */
+fl_snap fl_snapshot(flist l)
 {
 	if (l == NULL) {
-		printf("\nfl_subflist(): flist `l` does not exist...returning NULL\n");
+		printf("\nfl_snapshot(): flist `l` is NULL, returning NULL\n");
 		return NULL;
 	}
-	
-	if (!(a < b && b < l->len)) {
-		printf("\nfl_subflist(): indices out of range...returning NULL\n");
+
+	fl_snap s = (fl_snap) malloc(sizeof(fl_snap_type));
+	if (s == NULL) {
+		printf("\nfl_snapshot(): memory allocation for snapshot failed\n");
 		return NULL;
 	}
-		
-        flist sub = fl_make_flist();
-        fl_node start = fl_get_kth(l, a);
-	int steps = (b - a) + 1;
-	int i = 0;
-        while (i++ < steps) {
-		fl_append(sub, start->num);
-		start = start->next;
-        }
-        return sub;
+	if (l->log_head == NULL) {
+		l->log_head = fl_chunk_new_();
+		l->log_tail = l->log_head;
+		l->log_off = 0;
+		if (l->log_head == NULL) {
+			free(s);
+			return NULL;
+		}
+		fl_iter_type it;
+		double d;
+		fl_iter_at(l, 0, &it);
+		while (fl_iter_next(&it, &d))
+			fl_log_append_(l, d);
+		if (l->log_head == NULL) {
+			free(s);
+			return NULL;
+		}
+	}
+
+	s->first = l->log_head;
+	s->first->refs++;
+	s->off = l->log_off;
+	s->version = l->version;
+	s->mean = l->mean;
+	s->variance = l->variance;
+	s->std_dev = l->std_dev;
+	s->sumsq = l->sumsq;
+	s->sum = l->sum;
+	s->len = l->len;
+	return s;
 }
 
 
 /**
- * reverses flist in O(N) time
- *
- * note: reverses list via pointers, not vals
+ * value of the 0-indexed k-th element of snapshot `s`
  *
  * @nolan-h-hamilton
-*/
-flist fl_reverse(flist l)
+ */
+double fl_snap_get(fl_snap s, int k)
 {
-        if (l == NULL || l->len == 1) {
-                return l;
-        }
+	if (s == NULL || k < 0 || k >= s->len) {
+		printf("\nfl_snap_get(): index does not exist, returning NAN\n");
+		return NAN;
+	}
 
-        fl_node nd = l->head;
-        fl_node head_cpy = l->head;
-        fl_node nxt_cpy = NULL;
-        while (nd != l->tail) {
-                nxt_cpy = nd->next;
-                nd->next = nd->prev;
-                nd->prev = nxt_cpy;
-                nd = nxt_cpy;
-        }
-        nd->next = nd->prev;
-        nd->prev = nxt_cpy;
-        l->head = nd;
-        l->tail = head_cpy;
-	l->head->prev = l->tail;
-        return l;
+	/* every block but the last is full */
+	k += s->off;
+	fl_chunk c = s->first;
+	for (; k >= FL_CHUNK_LEN; k -= FL_CHUNK_LEN)
+		c = c->next;
+	return c->num[k];
 }
 
 
 /**
- * delete all nodes in `l` in O(N)
+ * convert snapshot to an array of double
  *
  * @nolan-h-hamilton
-*/
-void fl_destroy(flist l)
+ */
+double * fl_snap_to_arr(fl_snap s)
 {
-	if (l == NULL) {
-		printf("\nfl_destroy(): flist `l` does not exist...\n");
-		return;
+	if (s == NULL || s->len == 0) return NULL;
+
+	double * arr = (double *) malloc(sizeof(double)*s->len);
+	if (arr == NULL) {
+		printf("\nfl_snap_to_arr(): memory allocation for array failed\n");
+		return NULL;
 	}
-	
-	fl_node nd = l -> head;
-	while (nd != l -> tail) {
-		fl_node cpy = nd -> next;
-		free(nd);
-		nd = cpy;
+
+	fl_chunk c = s->first;
+	int j = s->off;
+	for (int i = 0; i < s->len; i++, j++) {
+		if (j == FL_CHUNK_LEN) {
+			c = c->next;
+			j = 0;
+		}
+		arr[i] = c->num[j];
 	}
-	free(nd);
+	return arr;
 }
 
 
-/**
- * print nodes in `l` with format: "node_addr: (*prev, num, *next)". O(N).
- *
- * @nolan-h-hamilton
-*/
-
-void fl_print(flist l)
+void fl_snap_release(fl_snap s)
 {
-	if (l == NULL) {
-		printf("\nfl_print(): flist `l` does not exist...\n");
+	if (s == NULL)
 		return;
-	}
-	
-        if (l->head == NULL && l != NULL) {
-                printf("\nfl_print(): empty flist\n");
-                return;
-        }
-
-        fl_node nd = l->head;
-        while (nd->next != l->head) {
-                fl_print_node(nd);
-                nd = nd->next;
-        }
-        fl_print_node(nd);
-        printf("\n");
-
+	fl_chunk_unref_(s->first);
+	free(s);
 }
 
 
 /**
- * print single node of flist in format: "node_ptr: (*prev, num, *next)"
+ * link `nd`, a node embedded in caller-owned memory with `num` already set,
+ * at the tail of `l` in O(1) without allocating; the measures are updated as
+ * by fl_append(). `l` must be empty or hold only intrusive nodes, and until it
+ * is empty again it never frees its nodes: fl_unlink(), fl_pop(),
+ * fl_remove_index() and friends only unlink them, while fl_append() and the
+ * other calls that allocate a node refuse to add one. a node can be
+ * on several flists at once by embedding one fl_node_type per membership.
+ * intrusive flists keep the plain node layout (no fl_set_rle(), fl_freeze()).
+ * under a pending fl_affine() a linked node's `num` holds the preimage of its
+ * value, as fl_append() stores it; fl_unlink() puts the value back.
  *
  * @nolan-h-hamilton
-*/
-void fl_print_node(fl_node nd)
+ */
+flist fl_link_tail(flist l, fl_node nd)
 {
-        if (nd == NULL) {
-                printf("\fl_print_node(): node is NULL\n");
-		return;
-        }
-        int has_next = 0;
-        int has_prev = 0;
-        double n = nd->num;
-        if (nd->next != NULL) {
-                has_next = 1;
-        }
-
-        if (nd->prev != NULL) {
-                has_prev = 1;
-        }
-
-        if (has_next && has_prev) {
-                printf("\n%p: (%p, %.7f, %p)", nd, nd->prev, nd->num, nd->next);
-                return;
-        }
+	if (l == NULL || nd == NULL) {
+		printf("\nfl_link_tail(): flist `l` or node `nd` is NULL, returning NULL\n");
+		return NULL;
+	}
+	if (l->ext) {
+		printf("\nfl_link_tail(): intrusive nodes need an flist without runs or segments\n");
+		return l;
+	}
+	if (fl_mixed_(l, 1, "fl_link_tail"))
+		return l;
+	if (l->rev) {
+		fl_flip_(l);
+		fl_link_head(l, nd);
+		fl_flip_(l);
+		return l;
+	}
+	/* the node holds the preimage under a pending transform, as fl_append() stores it */
+	double n = nd->num;
+	nd->num = fl_aff_store_(l, &n);
+	l->intrusive = 1;
+	fl_log_append_(l, n);
+	fl_hash_end_(l, n, 1, 0);
 
-        if (has_prev && !(has_next)) {
-                printf("\n%p: (%p, %.7f, NULL)", nd, nd->prev, nd->num);
-                return;
-        }
-        if (has_next && !(has_prev)) {
-                printf("\n%p: (NULL, %.7f, %p)", nd, nd->num, nd->next);
-                return;
-        }
-        else {
-                printf("\n%p: (NULL, %.7f, NULL)", nd, nd->num);
-        }
-        return;
+	if (l->len == 0) {
+		l->head = nd;
+		l->tail = nd;
+		nd->next = nd;
+		nd->prev = nd;
+		fl_sample_add_(l, nd);
+		return fl_update_measures_(l, n, nd->num, 1);
+	}
+	nd->prev = l->tail;
+	nd->next = l->head;
+	l->tail->next = nd;
+	l->head->prev = nd;
+	l->tail = nd;
+	fl_sample_add_(l, nd);
+	return fl_update_measures_(l, n, nd->num, 1);
 }
 
 
 /**
- * print basic info of flist
+ * link caller-owned node `nd` at the head of `l` in O(1), see fl_link_tail()
  *
  * @nolan-h-hamilton
-*/
-void fl_state(flist l)
+ */
+flist fl_link_head(flist l, fl_node nd)
 {
-        printf("\n\n");
-        if (l == NULL) {
-                printf("\nfl_state(): flist is null\n");
-		return;
-        }
-
-        printf("sum: %.3f\n", l->sum);
-        printf("mean: %.3f\n", l->mean);
-	printf("(est.) variance: %.3f\n", l->variance);
-	printf("(est.) standard deviation: %.3f\n", l->std_dev);
-	printf("length: %d\n", l->len);
-        if (l->head != NULL) {
-                printf("head: (%p, %.3f)\n", l->head, l->head->num);
-                if (l->head->prev != NULL) {
-                        printf("head prev: (%p, %.3f)\n", l->head->prev, l->head->prev->num);
-                } else {
-                        printf("head -> prev is NULL but head != NULL\n");
-                }
-        }
-
-        if (l->tail != NULL) {
-                printf("tail: (%p, %.3f)\n", l->tail, l->tail->num);
-                if (l->tail->next != NULL) {
-                        printf("tail next: (%p, %.3f)\n", l->tail->next, l->tail->next->num);
-                } else {
-                        printf("tail -> next is NULL but tail != NULL\n");
-                }
-        } else {
-                printf("fl_state(): flist is empty and has not been initialized\n");
-                return;
-        }
-
-        printf("empty?: %d\n", l->len==0);
-        printf("flist elements:");
-        fl_print(l);
+	if (l == NULL || nd == NULL) {
+		printf("\nfl_link_head(): flist `l` or node `nd` is NULL, returning NULL\n");
+		return NULL;
+	}
+	if (l->ext) {
+		printf("\nfl_link_head(): intrusive nodes need an flist without runs or segments\n");
+		return l;
+	}
+	if (fl_mixed_(l, 1, "fl_link_head"))
+		return l;
+	if (l->rev) {
+		fl_flip_(l);
+		fl_link_tail(l, nd);
+		fl_flip_(l);
+		return l;
+	}
+	if (l->len == 0)
+		return fl_link_tail(l, nd);
+	double n = nd->num;
+	nd->num = fl_aff_store_(l, &n);
+	l->intrusive = 1;
+	fl_touch_(l);
+	fl_hash_end_(l, n, 1, 1);
+	if (l->finger != NULL)
+		l->finger_idx++;
+	nd->prev = l->tail;
+	nd->next = l->head;
+	l->tail->next = nd;
+	l->head->prev = nd;
+	l->head = nd;
+	fl_sample_add_(l, nd);
+	return fl_update_measures_(l, n, nd->num, 1);
 }
 
 
 /**
- * Function that takes a flist and returns a complete copy of that flist using local references
+ * unlink node `nd`, which must be on `l`, in O(1) and update the measures.
+ * the node is not freed and keeps its value.
  *
- * @jamesdevftw
+ * @nolan-h-hamilton
  */
-flist fl_copy(flist currentFlist)
+flist fl_unlink(flist l, fl_node nd)
 {
-	if (currentFlist == NULL || currentFlist->head == NULL) {
-		printf("\nfl_copy(): flist `currentFlist` is NULL...\n");
+	if (l == NULL || nd == NULL || l->len == 0) {
+		printf("\nfl_unlink(): flist `l` is empty or node `nd` is NULL, returning NULL\n");
 		return NULL;
 	}
+	if (l->ext) {
+		printf("\nfl_unlink(): flist holds runs or segments, use fl_remove_index()\n");
+		return l;
+	}
+	if (l->rev) {
+		fl_flip_(l);
+		fl_unlink(l, nd);
+		fl_flip_(l);
+		return l;
+	}
+	/* the value is read through a pending transform, which stays pending */
+	double s = nd->num;
+	double n = fl_aff_(l, s);
 
-        fl_node nd = currentFlist->head;
-        flist newFlist = fl_make_flist();
-        
-        /* Iterate through both lists */
-        while (nd->next != currentFlist->head)
-        {
-                fl_push(newFlist, nd->num);
-                        nd = nd->next;
-                                        
-        }
+	if (nd == l->head) {
+		fl_log_pop_(l);
+		fl_hash_end_(l, n, 0, 1);
+		if (l->finger != NULL && l->finger != nd)
+			l->finger_idx--;
+	} else {
+		fl_touch_(l);
+		if (nd == l->tail)
+			fl_hash_end_(l, n, 0, 0);
+		/* the elements after `nd` move down one index */
+		if (nd != l->tail)
+			l->finger = NULL;
+	}
+	if (l->finger == nd)
+		l->finger = NULL;
+	fl_sampler_remove(l->sampler, nd);
 
-        fl_push(newFlist, nd->num);
-        return newFlist;
+	if (l->len == 1) {
+		l->head = NULL;
+		l->tail = NULL;
+	} else {
+		nd->prev->next = nd->next;
+		nd->next->prev = nd->prev;
+		if (nd == l->head)
+			l->head = nd->next;
+		if (nd == l->tail)
+			l->tail = nd->prev;
+	}
+	/* hand the node back holding its value */
+	nd->num = n;
+	return fl_update_measures_(l, n, s, 0);
+}
+
+
+static int fl_cmp_double_(const void * a, const void * b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+	return (x > y) - (x < y);
 }
 
 
 /**
- * Function that creates a copy of two lists and combines the copies together.
- * Function returns the combined copies.
- * @jamesdevftw
+ * determine if `l` and `m` hold the same values in any order. lists whose
+ * length or multiset fingerprint differ are rejected in O(1) (O(N) to
+ * refresh a fingerprint invalidated by fl_affine());
+ * otherwise sorted copies are compared exactly (==), like the fingerprint,
+ * in O(N log N).
+ *
+ * @nolan-h-hamilton
  */
-flist fl_combine(flist l, flist m)
+int fl_same_multiset(flist l, flist m)
 {
-	if (l == NULL && m == NULL) {
-		printf("\nfl_combine(): both flists empty, returning NULL\n");
+	if (l == NULL || m == NULL)
+		return l == m;
+	/* the sums are not compared: accumulated in another order they differ by rounding */
+	if (l->len != m->len)
+		return 0;
+	if (l->len == 0)
+		return 1;
+	if (!l->mhash_ok)
+		fl_hash_refresh_(l);
+	if (!m->mhash_ok)
+		fl_hash_refresh_(m);
+	if (l->mhash != m->mhash)
+		return 0;
+
+	double *a = fl_to_arr(l);
+	double *b = fl_to_arr(m);
+	int same = a != NULL && b != NULL;
+	if (same) {
+		qsort(a, l->len, sizeof(double), fl_cmp_double_);
+		qsort(b, m->len, sizeof(double), fl_cmp_double_);
+		for (int i = 0; i < l->len && same; i++)
+			same = a[i] == b[i];
+	}
+	free(a);
+	free(b);
+	return same;
+}
+
+
+/**
+ * start a batch of mutations of `l`. fl_batch_append(), fl_batch_push(),
+ * fl_batch_pop() and fl_batch_dequeue() only stage their change (a pop or
+ * dequeue returns the value it will remove), and fl_batch_commit() applies
+ * them all in one pass over the two ends: nodes are linked, the ring is
+ * closed and len/sum/sumsq are updated once. `l` must not be modified
+ * otherwise until the batch is committed or aborted; committing after such a
+ * change fails and leaves `l` as it is.
+ *
+ * @nolan-h-hamilton
+ */
+fl_batch fl_batch_begin(flist l)
+{
+	if (l == NULL) {
+		printf("\nfl_batch_begin(): flist `l` is NULL, returning NULL\n");
 		return NULL;
 	}
-	
-	if (l == NULL && m != NULL)
-		return m;
-	if (m == NULL && l != NULL)
-		return l;
-        flist newL = fl_copy(l);
-        flist newM = fl_copy(m);
-        
-        //Conncect the two flists
-        newL->tail->next = newM->head;
-        newM->tail->next = newL->head;
+	if (l->intrusive) {
+		printf("\nfl_batch_begin(): flist holds intrusive nodes, returning NULL\n");
+		return NULL;
+	}
+	fl_batch b = (fl_batch) calloc(1, sizeof(fl_batch_type));
+	if (b == NULL) {
+		printf("\nmemory allocation for fl_batch failed..returning NULL\n");
+		return NULL;
+	}
+	b->l = l;
+	b->version = l->version;
+	b->len = l->len;
+	b->ew_mean = l->ew_mean;
+	b->ew_variance = l->ew_variance;
+	b->ew_weight = l->ew_weight;
+	return b;
+}
+
 
-        //Recalculate measures
-        //Length, sum and mean
-        newL->len = (newL->len + newM->len);
-        newL->sum = (newL->sum + newM->sum); 
-        newL->mean = (newL->sum/newL->mean);
+/* make room for one more value after buf[start..len). returns 0 if out of memory */
+static int fl_batch_reserve_(double **buf, int *start, int *len, int *cap)
+{
+	if (*len < *cap)
+		return 1;
+	if (*start > 0) {
+		memmove(*buf, *buf + *start, sizeof(double) * (*len - *start));
+		*len -= *start;
+		*start = 0;
+		return 1;
+	}
+	int ncap = *cap > 0 ? 2 * *cap : 16;
+	double *nbuf = (double *) realloc(*buf, sizeof(double) * ncap);
+	if (nbuf == NULL)
+		return 0;
+	*buf = nbuf;
+	*cap = ncap;
+	return 1;
+}
 
-        //Sum squared
-        newL->sumsq = ((newL->sumsq) + (newM->sumsq));
-        double moment2 = newL->sumsq / newL->len;
 
-        //Variance
-        newL->variance = moment2 - (newL->mean*newL->mean);
+fl_batch fl_batch_append(fl_batch b, double n)
+{
+	if (b == NULL) {
+		printf("\nfl_batch_append(): batch `b` is NULL...returning NULL\n");
+		return NULL;
+	}
+	if (!fl_batch_reserve_(&b->back, &b->back_start, &b->back_len, &b->back_cap)) {
+		printf("\nfl_batch_append(): memory allocation failed...returning NULL\n");
+		return NULL;
+	}
+	b->back[b->back_len++] = n;
+	b->len++;
+	if (b->l->decay > 0 || b->l->decay_tau > 0)
+		fl_ew_step_(b->l, &b->ew_mean, &b->ew_variance, &b->ew_weight, n);
+	return b;
+}
 
-        //Standard Deviation
-        newL->std_dev = sqrt(newL->variance);
 
-        return newL;
+fl_batch fl_batch_push(fl_batch b, double n)
+{
+	if (b == NULL) {
+		printf("\nfl_batch_push(): batch `b` is NULL...returning NULL\n");
+		return NULL;
+	}
+	if (!fl_batch_reserve_(&b->front, &b->front_start, &b->front_len, &b->front_cap)) {
+		printf("\nfl_batch_push(): memory allocation failed...returning NULL\n");
+		return NULL;
+	}
+	b->front[b->front_len++] = n;
+	b->len++;
+	if (b->l->decay > 0 || b->l->decay_tau > 0)
+		fl_ew_step_(b->l, &b->ew_mean, &b->ew_variance, &b->ew_weight, n);
+	return b;
 }
 
 
 /**
- * convert flist to an array of double
+ * stage the removal of the head and return its value: the last value pushed
+ * in the batch, else the first element of `l` not yet staged for removal,
+ * else the first value appended in the batch. O(1) amortized.
  *
  * @nolan-h-hamilton
  */
-double * fl_to_arr(flist l)
+double fl_batch_pop(fl_batch b)
 {
-	if (l == NULL || l->head == NULL) return NULL;
-	
-	double * arr = (double *) malloc(sizeof(double)*l->len);
-	
-	if (arr == NULL) {
-		printf("\nfl_to_arr(): memory allocation for array failed\n");
-		return NULL;
+	if (b == NULL || b->len == 0) {
+		printf("\nfl_batch_pop(): cannot pop empty flist\n");
+		exit(1);
 	}
-	
-	for (int i = 0; i < l->len; i++) {
-		arr[i] = l->head->num;
-		l->head = l->head->next;
+	b->len--;
+	if (b->front_len > b->front_start)
+		return b->front[--b->front_len];
+	if (b->pops + b->dequeues < b->l->len)
+		return fl_get(b->l, b->pops++);
+	return b->back[b->back_start++];
+}
+
+
+/* stage the removal of the tail and return its value, see fl_batch_pop() */
+double fl_batch_dequeue(fl_batch b)
+{
+	if (b == NULL || b->len == 0) {
+		printf("\nfl_batch_dequeue(): cannot dequeue empty flist\n");
+		exit(1);
 	}
-	return arr;
+	b->len--;
+	if (b->back_len > b->back_start)
+		return b->back[--b->back_len];
+	if (b->pops + b->dequeues < b->l->len)
+		return fl_get(b->l, b->l->len - 1 - b->dequeues++);
+	return b->front[b->front_start++];
+}
+
+
+void fl_batch_abort(fl_batch b)
+{
+	if (b == NULL)
+		return;
+	free(b->front);
+	free(b->back);
+	free(b);
+}
+
+
+/*
+ * account for element `x`, stored as `s`, added to or removed from the head
+ * or tail of `l` by a batch in everything but len, sum and sumsq
+ */
+static void fl_batch_elem_(flist l, double x, double s, int add, int head)
+{
+	if (add && !head)
+		fl_log_append_(l, x);
+	if (!add && head)
+		fl_log_pop_(l);
+	fl_hash_end_(l, x, add, head);
+	if (l->sketch != NULL)
+		fl_sketch_add(l->sketch, s, add ? 1 : -1);
+	if (add)
+		l->mhash += fl_mhash_term_(x);
+	else
+		l->mhash -= fl_mhash_term_(x);
 }
 
 
 /**
- * copy vallues from `arr` to `l`
- *
- * note: will cast array values to double
+ * apply the mutations staged in `b` to its flist and free `b`. the nodes of
+ * the new elements are allocated up front, so if memory runs out nothing is
+ * applied. otherwise the removed elements are unlinked from the ends, the
+ * new nodes linked in front of and after what remains (merged into runs in
+ * run-length mode), the ring is closed once and len, sum, sumsq, mean,
+ * variance and std_dev are updated once. O(number of staged mutations).
+ * returns 1 on success, 0 if nothing was applied.
  *
  * @nolan-h-hamilton
  */
-void fl_from_arr(flist l, void * arr, int arr_len)
+int fl_batch_commit(fl_batch b)
 {
-	if (l == NULL) {
-		printf("\nfl_from_arr(): flist is null...return\n");
-		return;
+	if (b == NULL) {
+		printf("\nfl_batch_commit(): batch `b` is NULL...returning 0\n");
+		return 0;
 	}
-	if (arr == NULL) {
-		printf("\nfl_from_arr(): array is null...return\n");
-		return;
+	flist l = b->l;
+	if (l->version != b->version) {
+		printf("\nfl_batch_commit(): flist was modified during the batch, nothing applied\n");
+		fl_batch_abort(b);
+		return 0;
 	}
-	double *darr = (double *) arr;
-	for (int i = 0; i < arr_len; i++) {
-		l = fl_append(l, (double) darr[i]);
+
+	int nnew = b->front_len - b->front_start + b->back_len - b->back_start;
+	fl_node *nodes = (fl_node *) malloc(sizeof(fl_node) * (nnew > 0 ? nnew : 1));
+	int used = 0;
+	while (nodes != NULL && used < nnew && (nodes[used] = fl_new_node_(l, 0)) != NULL)
+		used++;
+	if (nodes == NULL || used < nnew) {
+		printf("\nfl_batch_commit(): memory allocation for nodes failed, nothing applied\n");
+		for (int i = 0; nodes != NULL && i < used; i++)
+			free(nodes[i]);
+		free(nodes);
+		fl_batch_abort(b);
+		return 0;
 	}
-}
 
+	/*
+	 * a pending transform stays pending and the new values are stored as
+	 * their preimages, unless it has no inverse for some of them
+	 */
+	if (l->aff_a != 1 || l->aff_b != 0) {
+		for (int i = b->front_start; i < b->front_len; i++)
+			if (!isfinite((b->front[i] - l->aff_b) / l->aff_a) && isfinite(b->front[i]))
+				fl_affine_fold_(l);
+		for (int i = b->back_start; i < b->back_len; i++)
+			if (!isfinite((b->back[i] - l->aff_b) / l->aff_a) && isfinite(b->back[i]))
+				fl_affine_fold_(l);
+	}
+	/* a reversed flist is committed to flipped: its front is the other end */
+	int rev = l->rev;
+	double *front = b->front;
+	int fs = b->front_start, fe = b->front_len;
+	double *back = b->back;
+	int bs = b->back_start, be = b->back_len;
+	int pops = b->pops, deqs = b->dequeues;
+	if (rev) {
+		fl_flip_(l);
+		front = b->back;
+		fs = b->back_start;
+		fe = b->back_len;
+		back = b->front;
+		bs = b->front_start;
+		be = b->front_len;
+		pops = b->dequeues;
+		deqs = b->pops;
+	}
 
+	if (fe > fs || deqs > 0)
+		fl_touch_(l);
+	else
+		l->version++;
+	l->finger = NULL;
 
+	/* thaw frozen segments holding elements to be removed */
+	fl_node nd = l->head;
+	for (int i = 0; l->segs > 0 && i < pops; i += fl_node_count(l, nd), nd = nd->next)
+		if (fl_is_seg_(l, nd))
+			nd = fl_thaw_(l, nd);
+	nd = l->tail;
+	for (int i = 0; l->segs > 0 && i < deqs; ) {
+		if (fl_is_seg_(l, nd)) {
+			fl_node after = nd->next;
+			int only = after == nd;
+			fl_thaw_(l, nd);
+			nd = only ? l->tail : after->prev;
+			continue;
+		}
+		i += fl_node_count(l, nd);
+		nd = nd->prev;
+	}
 
-/* used for fl_sort() */
-fl_node fl_merge_(fl_node A, fl_node B) {
-	if (A == NULL) return B;
-	if (B == NULL) return A;
-	fl_node C = NULL;
-	fl_node last = NULL;
-	while (A != NULL && B != NULL) {
-		if (A->num  < B->num) {
-			if (C == NULL) {
-				C = A;
-			}
-			else {
-				last->next = A;
-			}
-			last = A;
-			last->prev = last;
-			A = A->next;
+	/* unlink the removed elements; the ring is closed again at the end */
+	fl_moments_type gone = fl_moments_of(0, 0);
+	fl_moments_type added = fl_moments_of(0, 0);
+	int left = l->len - pops - deqs;
+	fl_node head = l->head;
+	fl_node tail = l->tail;
+	for (int k = pops; k > 0; ) {
+		int c = fl_node_count(l, head);
+		int take = c < k ? c : k;
+		double x = fl_aff_(l, head->num);
+		fl_moments_type run = fl_moments_of(x, take);
+		fl_moments_merge(&gone, &run, 1);
+		for (int i = 0; i < take; i++)
+			fl_batch_elem_(l, x, head->num, 0, 1);
+		k -= take;
+		if (take < c) {
+			((fl_run) head)->count -= take;
+			break;
 		}
-		else {
-			if (C == NULL) {
-				C = B;
-			}
-			else {
-				last->next = B;
-			}
-			last = B;
-			last->prev = last;
-			B = B->next;
+		fl_node nxt = head->next;
+		fl_free_node_(l, head);
+		head = nxt;
+	}
+	for (int k = deqs; k > 0; ) {
+		int c = fl_node_count(l, tail);
+		int take = c < k ? c : k;
+		double x = fl_aff_(l, tail->num);
+		fl_moments_type run = fl_moments_of(x, take);
+		fl_moments_merge(&gone, &run, 1);
+		for (int i = 0; i < take; i++)
+			fl_batch_elem_(l, x, tail->num, 0, 0);
+		k -= take;
+		if (take < c) {
+			((fl_run) tail)->count -= take;
+			break;
 		}
+		fl_node prv = tail->prev;
+		fl_free_node_(l, tail);
+		tail = prv;
 	}
-	if (A == NULL) {
-		last->next = B;
-		B->prev = last;
+	if (left == 0) {
+		head = NULL;
+		tail = NULL;
+		/* nothing is stored under the transform anymore */
+		l->aff_a = 1;
+		l->aff_b = 0;
 	}
-	else {
-		last -> next = A;
-		A->prev = last;
+
+	/* link the pushed values, first pushed innermost, then the appended ones */
+	int next = 0;
+	for (int i = fs; i < fe; i++) {
+		double x = front[i];
+		double s = fl_aff_store_(l, &x);
+		fl_moments_type one = fl_moments_of(x, 1);
+		fl_batch_elem_(l, x, s, 1, 1);
+		fl_moments_merge(&added, &one, 1);
+		if (l->rle && head != NULL && !fl_is_seg_(l, head) && fl_same_bits_(head->num, s)) {
+			((fl_run) head)->count++;
+			continue;
+		}
+		nd = nodes[next++];
+		nd->num = s;
+		nd->next = head;
+		if (head != NULL)
+			head->prev = nd;
+		else
+			tail = nd;
+		head = nd;
+		fl_sampler_insert(l->sampler, nd, (long) left + next);
 	}
-	return C;
-}
+	for (int i = bs; i < be; i++) {
+		double x = back[i];
+		double s = fl_aff_store_(l, &x);
+		fl_moments_type one = fl_moments_of(x, 1);
+		fl_batch_elem_(l, x, s, 1, 0);
+		fl_moments_merge(&added, &one, 1);
+		if (l->rle && tail != NULL && !fl_is_seg_(l, tail) && fl_same_bits_(tail->num, s)) {
+			((fl_run) tail)->count++;
+			continue;
+		}
+		nd = nodes[next++];
+		nd->num = s;
+		nd->prev = tail;
+		if (tail != NULL)
+			tail->next = nd;
+		else
+			head = nd;
+		tail = nd;
+		fl_sampler_insert(l->sampler, nd, (long) left + next);
+	}
+	if (head != NULL) {
+		head->prev = tail;
+		tail->next = head;
+	}
+	l->head = head;
+	l->tail = tail;
+	while (next < nnew)
+		free(nodes[next++]);
+	free(nodes);
+	l->hash_fixed = 0;
 
+	/* one update of the measures for the whole batch */
+	fl_moments_type g = fl_mom_get_(l);
+	fl_moments_merge(&g, &gone, 0);
+	fl_moments_merge(&g, &added, 1);
+	fl_mom_set_(l, &g);
+	l->ew_mean = b->ew_mean;
+	l->ew_variance = b->ew_variance;
+	l->ew_weight = b->ew_weight;
 
-/* used for fl_sort() */
-fl_node fl_split_(fl_node head) 
-{ 
-    fl_node fast = head, slow = head; 
-    while (fast->next && fast->next->next) 
-    { 
-        fast = fast->next->next; 
-        slow = slow->next; 
-    } 
-    fl_node temp = slow->next; 
-    slow->next = NULL; 
-    return temp; 
+	if (rev)
+		fl_flip_(l);
+	fl_batch_abort(b);
+	return 1;
 }
 
 
-/* used for fl_sort() */
-fl_node fl_merge_sort_(fl_node head) {
+/**
+ * move the nodes of `l` into one contiguous block in logical order and relink
+ * them in O(N), so that traversals walk memory sequentially again after many
+ * insertions and removals in the middle. the old nodes are freed, a block
+ * left by a previous compaction at once. frozen segments stay where they
+ * are. node pointers and iterators obtained before are invalidated.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_compact(flist l)
+{
+	if (l == NULL) {
+		printf("\nfl_compact(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	if (l->intrusive) {
+		printf("\nfl_compact(): flist holds intrusive nodes, which belong to the caller\n");
+		return l;
+	}
+	l->walk_steps = 0;
+	l->walk_jumps = 0;
+	if (l->len == 0)
+		return l;
+	fl_unreverse_(l);
 
-	if (head == NULL || head->next == NULL) {
-		return head;
+	int count = 0;
+	int movable = 0;
+	fl_node nd = l->head;
+	do {
+		count++;
+		movable += !fl_is_seg_(l, nd);
+		nd = nd->next;
+	} while (nd != l->head);
+	if (movable == 0)
+		return l;
+
+	size_t stride = l->ext ? sizeof(fl_run_type) : sizeof(fl_node_type);
+	fl_slab s = (fl_slab) malloc(sizeof(fl_slab_type));
+	char *block = (char *) malloc(stride * movable);
+	if (s == NULL || block == NULL) {
+		printf("\nfl_compact(): memory allocation for node block failed\n");
+		free(s);
+		free(block);
+		return l;
 	}
-	fl_node second = fl_split_(head);
+	s->nodes = block;
+	s->stride = stride;
+	s->cap = movable;
+	s->live = movable;
 
-	head = fl_merge_sort_(head); 
-	second = fl_merge_sort_(second); 
-	return fl_merge_(head,second); 
+	fl_slab old = l->slab;
+	fl_node first = NULL;
+	fl_node last = NULL;
+	int used = 0;
+	nd = l->head;
+	for (int i = 0; i < count; i++) {
+		fl_node nxt = nd->next;
+		fl_node cpy = nd;
+		if (!fl_is_seg_(l, nd)) {
+			cpy = (fl_node) (block + stride * used++);
+			memcpy(cpy, nd, stride);
+			if (l->finger == nd)
+				l->finger = cpy;
+			fl_sampler_move(l->sampler, nd, cpy);
+			/* nodes of the old block go with it below */
+			if (!fl_in_slab_(old, nd))
+				free(nd);
+		}
+		cpy->prev = last;
+		if (last != NULL)
+			last->next = cpy;
+		else
+			first = cpy;
+		last = cpy;
+		nd = nxt;
+	}
+	first->prev = last;
+	last->next = first;
+	l->head = first;
+	l->tail = last;
+	if (old != NULL) {
+		free(old->nodes);
+		free(old);
+	}
+	l->slab = s;
+	return l;
 }
 
 
 /**
- * sort nodes in flist in O(N log N)
+ * set the threshold for fl_maybe_compact(): `l` is compacted (see
+ * fl_compact()) when, over the steps from node to node taken by traversals
+ * since the last check, more than the fraction `threshold` jumped in memory.
+ * no other call compacts, so node pointers stay valid until the caller asks
+ * for the check. 0 disables.
  *
  * @nolan-h-hamilton
  */
-flist fl_sort(flist l) {
-	if (l == NULL || l->len == 0)
+flist fl_set_auto_compact(flist l, double threshold)
+{
+	if (l == NULL) {
+		printf("\nfl_set_auto_compact(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	if (!(threshold >= 0 && threshold <= 1)) {
+		printf("\nfl_set_auto_compact(): `threshold` must be in [0, 1]\n");
 		return l;
-	fl_node hd_cpy = l->head;
-	hd_cpy->prev->next = NULL;
-	hd_cpy = fl_merge_sort_(hd_cpy);
-	l->head = hd_cpy;
-	fl_node iter = l->head;
-	while (iter->next != NULL) {
-		iter = iter->next;
 	}
-	l->tail = iter;
-	l->tail->next = l->head;
-	l->head->prev = l->tail;
-
+	l->compact_at = threshold;
+	l->walk_steps = 0;
+	l->walk_jumps = 0;
 	return l;
 }
+
+
 /**
- * determine if values in flist are sorted in O(N)
+ * compact `l` if traversals since the last check took at least len steps and
+ * more than the threshold set by fl_set_auto_compact() of them jumped in
+ * memory, then start counting again. returns 1 if `l` was compacted, which
+ * invalidates node pointers and iterators obtained before, as fl_compact()
+ * does. an flist holding intrusive nodes is never moved.
  *
  * @nolan-h-hamilton
  */
-int fl_is_sorted(flist l) {
+int fl_maybe_compact(flist l)
+{
 	if (l == NULL) {
-		printf("\nfl_is_sorted(): flist is NULL, returning -1\n");
-		return -1;
+		printf("\nfl_maybe_compact(): flist `l` is NULL, returning 0\n");
+		return 0;
 	}
+	if (l->intrusive || l->compact_at <= 0 || l->len < 2
+	    || l->walk_steps < (unsigned long) l->len)
+		return 0;
+	int moved = l->walk_jumps > l->compact_at * l->walk_steps;
+	if (moved)
+		fl_compact(l);
+	l->walk_steps = 0;
+	l->walk_jumps = 0;
+	return moved;
+}
 
-	if (l->len == 0) return 1;
-	
-	fl_node hd_cpy = l->head->next;
-	while (hd_cpy != l->head) {
-		if (hd_cpy->num < hd_cpy->prev->num) {
-			return 0;
-		}
-		hd_cpy = hd_cpy->next;
-	}
 
-	return 1;
+/**
+ * fraction of the steps from node to node taken by traversals of `l` (since
+ * the last compaction or automatic check) that jumped in memory rather than
+ * moving to a nearby node; 0 before any traversal
+ *
+ * @nolan-h-hamilton
+ */
+double fl_fragmentation(flist l)
+{
+	if (l == NULL || l->walk_steps == 0)
+		return 0;
+	return (double) l->walk_jumps / l->walk_steps;
 }
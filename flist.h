@@ -1,120 +1,474 @@
-#include <stdlib.h>
-#include <stdio.h>
-
-
-/**
- * flist is a doubly-linked, circular linked-list of double values with O(1) access
- * to head and tail. In addition, each creation/removal of a node in flist results
- * in immediate constant-time recomputing of mean, std_dev, variance, sum, and
- * length of the flist. These values are stored as fields in the flist struct
- * for access in O(1) time.
- *
- * @nolan-h-hamilton
- * @jamesdevftw
- */
-
-
-#ifndef FLIST_H_
-#define FLIST_H_
-
-/* Structs */
-
-typedef struct fl_node {
-        double num;
-        struct fl_node *prev;
-        struct fl_node *next;
-} fl_node_type, *fl_node;
-
-
-/*
- * only add fields to this struct which can be computed
- * at each addition/removal to the flist with a single computation. some
- * features to consider might be min, max, std_dev(single-pass estimator)
- */
-typedef struct {
-        fl_node head;
-        fl_node tail;
-        double mean;
-	double variance;
-	double std_dev;
-	double sumsq;
-        double sum;
-        int len;
-} flist_type, *flist;
-
-/***************/
-
-/* Functions */
-
-int fl_near(double a, double b);
-
-fl_node fl_make_node(double n);
-
-flist fl_make_flist();
-
-/* after a node has been removed or added to flist, update mean, sum, len fields appropriately */
-flist fl_update_measures(flist l, double n, int add);
-
-/* append to flist in O(1) time */
-flist fl_append(flist l, double n);
-
-
-fl_node fl_find(flist l, double n);
-
-/* returns the (0-indexed) k-th element of flist l in O(n) (n/2 max steps)*/
-fl_node fl_get_kth(flist l, int k);
-
-
-/* allows for use of flist as a stack. O(1). */
-flist fl_push(flist l, double n);
-
-
-/* allows for use of flist as a stack. O(1). */
-double fl_pop(flist l);
-
-/* allows for use of flist as a queue. O(1). */
-double fl_dequeue(flist l);
-
-/* remove element at index in O(k) k <= len(list) */
-flist fl_remove_index(flist l, int index);
-
-flist fl_remove(flist l, double n);
-/* inserts element with value `n` after the provided index in O(k) time, k = index <= len(list)*/
-flist fl_insert_index(flist l, int index, double n);
-
-flist fl_insert(flist l, double n);
-
-
-flist fl_subflist(flist l, int a, int b);
-
-flist fl_reverse(flist l);
-
-void fl_destroy(flist l);
-
-
-/* starting at head and ending at tail, print nodes of flist in format: "node_ptr: (*prev, num, *next)" */
-void fl_print(flist l);
-
-/* print single node of flist in format: "node_ptr: (*prev, num, *next)" */
-void fl_print_node(fl_node nd);
-
-
-/* print basic info of flist */
-void fl_state(flist l);
-
-int fl_equals(flist l, flist m);
-
-flist fl_combine(flist l, flist m);
-
-flist fl_copy(flist currentFlist);
-
-flist fl_sort(flist l);
-
-double * fl_to_arr(flist l);
-
-void fl_from_arr(flist l, void * arr, int arr_len);
-
-int fl_is_sorted(flist l);
-/*********************/
-
-#endif
+#include <stdlib.h>
+#include <stdio.h>
+
+
+/**
+ * flist is a doubly-linked, circular linked-list of double values with O(1) access
+ * to head and tail. In addition, each creation/removal of a node in flist results
+ * in immediate constant-time recomputing of mean, std_dev, variance, sum, and
+ * length of the flist. These values are stored as fields in the flist struct
+ * for access in O(1) time.
+ *
+ * @nolan-h-hamilton
+ * @jamesdevftw
+ */
+
+
+#ifndef FLIST_H_
+#define FLIST_H_
+
+#include "flist_sketch.h"
+#include "flist_sample.h"
+
+/* Structs */
+
+typedef struct fl_node {
+        double num;
+        struct fl_node *prev;
+        struct fl_node *next;
+} fl_node_type, *fl_node;
+
+
+/*
+ * node layout of flists in run-length mode (see fl_set_rle()) or holding
+ * frozen segments (see fl_freeze()): a run of `count` consecutive elements
+ * equal to node.num, or, if `seg` is set, an fl_seg_type. plain flists keep
+ * the smaller fl_node_type, so `count` costs nothing unless it is used.
+ */
+typedef struct {
+	fl_node_type node;
+	int count;
+	int seg;
+} fl_run_type, *fl_run;
+
+
+/* a segment restarts its encoding every FL_SEG_BLOCK elements */
+#define FL_SEG_BLOCK 64
+
+/*
+ * frozen segment: `run.count` consecutive elements XOR-compressed into
+ * `data` (Gorilla encoding). run.node.num holds the first element. the first
+ * element of each block of FL_SEG_BLOCK is stored whole, starting at bit
+ * marks[block], so decoding can start at any block, e.g. to read the
+ * segment backwards.
+ */
+typedef struct {
+	fl_run_type run;
+	unsigned char *data;
+	size_t nbytes;
+	size_t *marks;
+} fl_seg_type, *fl_seg;
+
+
+/* elements per block of the snapshot log */
+#define FL_CHUNK_LEN 128
+
+/*
+ * reference-counted block of the append-only log that backs snapshots (see
+ * fl_snapshot()). slots [0, used) are written once and never modified, so
+ * blocks are shared between an flist and its snapshots without copying. each
+ * block holds a reference to `next`.
+ */
+typedef struct fl_chunk {
+	struct fl_chunk *next;
+	int refs;
+	int used;
+	double num[FL_CHUNK_LEN];
+} fl_chunk_type, *fl_chunk;
+
+
+/*
+ * contiguous block of nodes laid out by fl_compact(). a node removed from the
+ * list stays in the block, which is freed once `live` drops to 0.
+ */
+typedef struct {
+	char *nodes;
+	size_t stride;
+	int cap;
+	int live;
+} fl_slab_type, *fl_slab;
+
+
+/*
+ * only add fields to this struct which can be computed
+ * at each addition/removal to the flist with a single computation. some
+ * features to consider might be min, max, std_dev(single-pass estimator)
+ */
+typedef struct {
+        fl_node head;
+        fl_node tail;
+        double mean;
+	double variance;
+	double std_dev;
+	double sumsq;
+        double sum;
+        int len;
+	/* compensation terms of sum and sumsq, see fl_update_measures() */
+	double sum_c;
+	double sumsq_c;
+	/* sums of squared, cubed and 4th-power deviations from the mean: variance is m2/len */
+	double m2;
+	double m3;
+	double m4;
+	/* sample skewness and excess kurtosis, 0 while all elements are equal */
+	double skewness;
+	double kurtosis;
+	/* exponentially weighted measures, see fl_set_decay() */
+	double decay;
+	double decay_tau;
+	double ew_mean;
+	double ew_variance;
+	double ew_weight;
+	double ew_ts;
+	/* optional quantile sketch, see fl_enable_sketch() */
+	fl_sketch sketch;
+	/* optional uniform sample of the elements, see fl_enable_sample() */
+	fl_sampler sampler;
+	/* nonzero if equal neighbouring values are merged into runs */
+	int rle;
+	/* nonzero if nodes use the fl_run_type layout (runs or segments) */
+	int ext;
+	/* number of frozen segments in the ring */
+	int segs;
+	/* node found by the last positional lookup and the index of its first element */
+	fl_node finger;
+	int finger_idx;
+	/* pending transform x -> aff_a*x + aff_b of the stored values, see fl_affine() */
+	double aff_a;
+	double aff_b;
+	/* incremented by every modification */
+	unsigned long version;
+	/* snapshot log: elements are log_head->num[log_off...], NULL if inactive */
+	fl_chunk log_head;
+	fl_chunk log_tail;
+	int log_off;
+	/* nonzero once caller-owned nodes are linked, see fl_link_tail() */
+	int intrusive;
+	/*
+	 * nonzero after an odd number of fl_reverse() calls: head and tail are
+	 * swapped and the ring is walked from head to tail through `prev`
+	 */
+	int rev;
+	/*
+	 * content fingerprints, see fl_equals(): `hash` is order-sensitive and
+	 * valid if hash_ok, `mhash` ignores order and is valid if mhash_ok
+	 */
+	unsigned long long hash;
+	/* order-sensitive fingerprint of the reversed list */
+	unsigned long long hash_rev;
+	/* B^len for the polynomial `hash` */
+	unsigned long long hash_pow;
+	unsigned long long mhash;
+	int hash_ok;
+	int mhash_ok;
+	/* set while a change at the ends has already been hashed */
+	int hash_fixed;
+	/* nodes placed by the last fl_compact(), NULL if none are left */
+	fl_slab slab;
+	/* steps between nodes during traversals, and those that jumped far in memory */
+	unsigned long walk_steps;
+	unsigned long walk_jumps;
+	/* fraction of jumps above which fl_maybe_compact() compacts `l`, see fl_set_auto_compact() */
+	double compact_at;
+} flist_type, *flist;
+
+
+/*
+ * moments of a group of values, see fl_moments_merge(): count, sums with
+ * their compensation terms, mean and m2, m3, m4, the sums of 2nd, 3rd and
+ * 4th powers of the deviations from the mean
+ */
+typedef struct {
+	int n;
+	double sum;
+	double sum_c;
+	double sumsq;
+	double sumsq_c;
+	double mean;
+	double m2;
+	double m3;
+	double m4;
+} fl_moments_type, *fl_moments;
+
+
+/* immutable view of an flist taken by fl_snapshot() */
+typedef struct {
+	fl_chunk first;
+	int off;
+	unsigned long version;
+        double mean;
+	double variance;
+	double std_dev;
+	double sumsq;
+        double sum;
+        int len;
+} fl_snap_type, *fl_snap;
+
+
+/*
+ * mutations of `l` staged by fl_batch_begin() and applied together by
+ * fl_batch_commit(). front[front_start..front_len) holds the pushed values
+ * (the last one becomes the head), back[back_start..back_len) the appended
+ * ones; `pops` and `dequeues` elements of `l` are removed from its ends.
+ */
+typedef struct {
+	flist l;
+	unsigned long version;
+	double *front;
+	int front_start;
+	int front_len;
+	int front_cap;
+	double *back;
+	int back_start;
+	int back_len;
+	int back_cap;
+	int pops;
+	int dequeues;
+	/* length `l` will have after the commit */
+	int len;
+	/* weighted measures of `l` after the staged insertions */
+	double ew_mean;
+	double ew_variance;
+	double ew_weight;
+} fl_batch_type, *fl_batch;
+
+
+/* sequential reader over the elements of an flist, see fl_iter_at() */
+typedef struct {
+	flist l;
+	fl_node nd;
+	int off;
+	int left;
+	/* segment decoder state */
+	size_t bit;
+	unsigned long long prev;
+	int lead;
+	int mlen;
+	/* nonzero if the flist is reversed and read through `prev`, see fl_reverse() */
+	int rev;
+	/* block `blk_no` of segment `blk_nd`, decoded to be read backwards */
+	fl_node blk_nd;
+	int blk_no;
+	double blk[FL_SEG_BLOCK];
+} fl_iter_type, *fl_iter;
+
+/***************/
+
+/* Functions */
+
+int fl_near(double a, double b);
+
+fl_node fl_make_node(double n);
+
+flist fl_make_flist();
+
+/* after a node has been removed or added to flist, update mean, sum, len fields appropriately */
+flist fl_update_measures(flist l, double n, int add);
+
+/* add `x` to the compensated sum *s + *c (Neumaier) */
+void fl_kahan_add(double * s, double * c, double x);
+
+/* moments of `c` copies of `x` */
+fl_moments_type fl_moments_of(double x, int c);
+
+/* merge group `b` into `a` (add != 0) or take it out; returns b's mean minus the other group's. O(1) */
+double fl_moments_merge(fl_moments a, const fl_moments_type * b, int add);
+
+/* recompute the measures from the elements in O(N) and report any that differ by more than relative `tol` (debugging) */
+int fl_check_measures(flist l, double tol);
+
+/* append to flist in O(1) time */
+flist fl_append(flist l, double n);
+
+/* enable per-sample EWMA with smoothing factor 0 < `alpha` <= 1 (0 disables) */
+flist fl_set_decay(flist l, double alpha);
+
+/* enable time-decayed EWMA with time constant `tau` (0 disables) */
+flist fl_set_time_decay(flist l, double tau);
+
+/* append/push a sample observed at time `t`. O(1) */
+flist fl_append_ts(flist l, double n, double t);
+
+flist fl_push_ts(flist l, double n, double t);
+
+/* attach a quantile sketch with relative accuracy `alpha`, fed by every insertion/removal */
+flist fl_enable_sketch(flist l, double alpha, int max_bins);
+
+/* approximate `q`-quantile in O(sketch size). requires fl_enable_sketch() */
+double fl_quantile(flist l, double q);
+
+/* keep a uniform sample of up to `size` elements, maintained by every insertion/removal (0 disables) */
+flist fl_enable_sample(flist l, int size);
+
+/* copy a uniform sample of min(k, sample size) elements to `buf` in O(k), return how many */
+int fl_sample(flist l, double * buf, int k);
+
+
+fl_node fl_find(flist l, double n);
+
+/* returns the (0-indexed) k-th element of flist l in O(n) (n/2 max steps)*/
+fl_node fl_get_kth(flist l, int k);
+
+/* switch run-length storage on/off, converting existing nodes in O(n) */
+flist fl_set_rle(flist l, int on);
+
+/* number of elements held by node `nd` of `l` (run or segment length, else 1) */
+int fl_node_count(flist l, fl_node nd);
+
+/* compress elements at indexes a::b into one frozen segment. O(N) */
+flist fl_freeze(flist l, int a, int b);
+
+/* decompress every frozen segment of `l` back into nodes */
+flist fl_thaw_all(flist l);
+
+/* position `it` at the k-th element of `l` */
+void fl_iter_at(flist l, int k, fl_iter it);
+
+/* store the next element in `out` and return 1, or return 0 at the end. O(1) amortized */
+int fl_iter_next(fl_iter it, double * out);
+
+/* value of the k-th element, without thawing or folding a pending transform */
+double fl_get(flist l, int k);
+
+/* replace every element x by a*x + b in O(1), updating the measures analytically */
+flist fl_affine(flist l, double a, double b);
+
+/* fl_affine(l, a, 0) */
+flist fl_scale(flist l, double a);
+
+/* fl_affine(l, 1, b) */
+flist fl_offset(flist l, double b);
+
+
+/* allows for use of flist as a stack. O(1). */
+flist fl_push(flist l, double n);
+
+
+/* allows for use of flist as a stack. O(1). */
+double fl_pop(flist l);
+
+/* allows for use of flist as a queue. O(1). */
+double fl_dequeue(flist l);
+
+/* remove element at index in O(k) k <= len(list) */
+flist fl_remove_index(flist l, int index);
+
+flist fl_remove(flist l, double n);
+
+/* remove every element for which `pred(value, ctx)` is nonzero in one O(N) pass. returns the count removed */
+int fl_remove_if(flist l, int (*pred)(double, void *), void * ctx);
+
+/* remove every element fl_near() `n` in one O(N) pass. returns the count removed */
+int fl_remove_all(flist l, double n);
+/* insert `n` so that it becomes the element at `index`, 0 <= index < len - 1; index len - 1 appends. O(min(index, len - index)) */
+flist fl_insert_index(flist l, int index, double n);
+
+flist fl_insert(flist l, double n);
+
+
+flist fl_subflist(flist l, int a, int b);
+
+/* reverse the order of the elements in O(1) */
+flist fl_reverse(flist l);
+
+/* make the element at index `k` (mod len) the head in O(min(k, len - k)) */
+flist fl_rotate(flist l, int k);
+
+void fl_destroy(flist l);
+
+
+/* starting at head and ending at tail, print nodes of flist in format: "node_ptr: (*prev, num, *next)" */
+void fl_print(flist l);
+
+/* print single node of flist in format: "node_ptr: (*prev, num, *next)" */
+void fl_print_node(fl_node nd);
+
+
+/* print basic info of flist */
+void fl_state(flist l);
+
+/* 1 if `l` and `m` hold exactly the same values in order. O(1) rejection by fingerprint, O(N) after a change away from the ends */
+int fl_equals(flist l, flist m);
+
+/* 1 if `l` and `m` hold exactly the same values in any order. O(1) rejection by fingerprint, O(N) after fl_affine() */
+int fl_same_multiset(flist l, flist m);
+
+flist fl_combine(flist l, flist m);
+
+flist fl_copy(flist currentFlist);
+
+flist fl_sort(flist l);
+
+double * fl_to_arr(flist l);
+
+void fl_from_arr(flist l, void * arr, int arr_len);
+
+int fl_is_sorted(flist l);
+
+/* multiset union of sorted flists as a new sorted flist. O(N + M) */
+flist fl_union(flist l, flist m);
+
+/* multiset intersection of sorted flists as a new sorted flist. O(N + M) */
+flist fl_intersection(flist l, flist m);
+
+/* elements of sorted `l` not cancelled by an equal element of sorted `m`. O(N + M) */
+flist fl_difference(flist l, flist m);
+
+/* merge `k` sorted flists into a new sorted flist in O(N log k) */
+flist fl_merge_sorted(flist * lists, int k);
+
+/* immutable view of the elements and measures of `l`. O(1) while only appends/pops happen */
+fl_snap fl_snapshot(flist l);
+
+/* value of the k-th element of snapshot `s`. O(k / FL_CHUNK_LEN) */
+double fl_snap_get(fl_snap s, int k);
+
+double * fl_snap_to_arr(fl_snap s);
+
+/* free `s` and drop its references to the log */
+void fl_snap_release(fl_snap s);
+
+/* link caller-owned node `nd` (num set) at the tail without allocating. O(1) */
+flist fl_link_tail(flist l, fl_node nd);
+
+/* link caller-owned node `nd` (num set) at the head without allocating. O(1) */
+flist fl_link_head(flist l, fl_node nd);
+
+/* unlink node `nd` from `l` without freeing it. O(1) */
+flist fl_unlink(flist l, fl_node nd);
+
+/* relink the nodes of `l` in logical order in one contiguous block. O(N) */
+flist fl_compact(flist l);
+
+/*
+ * set the fraction of the steps of recent traversals that must jump in memory
+ * for fl_maybe_compact() to compact `l` (0 disables)
+ */
+flist fl_set_auto_compact(flist l, double threshold);
+
+/* compact `l` if fragmented past the fl_set_auto_compact() threshold; 1 if it did (invalidates held nodes) */
+int fl_maybe_compact(flist l);
+
+/* fraction of the steps of traversals since the last compaction check that jumped in memory */
+double fl_fragmentation(flist l);
+
+/* start staging appends, pushes, pops and dequeues on `l` */
+fl_batch fl_batch_begin(flist l);
+
+fl_batch fl_batch_append(fl_batch b, double n);
+
+fl_batch fl_batch_push(fl_batch b, double n);
+
+/* value the head will have when popped at this point of the batch */
+double fl_batch_pop(fl_batch b);
+
+double fl_batch_dequeue(fl_batch b);
+
+/* apply the staged mutations with one update of the measures and free `b`. returns 1 on success */
+int fl_batch_commit(fl_batch b);
+
+/* drop the staged mutations, leaving `l` unchanged, and free `b` */
+void fl_batch_abort(fl_batch b);
+/*********************/
+
+#endif
@@ -0,0 +1,700 @@
+/**
+ * flist.hpp is a header-only C++ counterpart of flist.c: a doubly-linked,
+ * circular linked-list of numeric values with O(1) access to head and tail.
+ *
+ * unlike the C flist, the element type and the set of measures maintained on
+ * every insertion/removal are template parameters, so a list that only needs
+ * e.g. the sum never pays for sumsq/min/max updates:
+ *
+ *     fl::flist<double>                        sum, sumsq, mean, variance, std_dev
+ *     fl::flist<float, fl::no_stats>           plain list, no bookkeeping
+ *     fl::flist<int64_t, fl::sum_stats>        integer sum only (wraps modulo 2^64)
+ *     fl::flist<double, fl::stats<fl::variance_stats, fl::minmax_stats> >
+ *
+ * the ring is closed through a sentinel link owned by the list, so head is
+ * sentinel.next and tail is sentinel.prev; this gives STL-style end()
+ * iterators that stay valid across insertions and removals.
+ *
+ * @nolan-h-hamilton
+ */
+
+#ifndef FLIST_HPP_
+#define FLIST_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace fl {
+
+namespace detail {
+
+/*
+ * integer lists report their sum as a long long and floating point lists as a
+ * double. integer sums are kept in unsigned long long, which wraps modulo
+ * 2^64 like flist_i64, so the sum is exact while it fits a long long and
+ * never overflows into undefined behavior.
+ */
+template <typename T>
+struct accum {
+	typedef typename std::conditional<std::is_integral<T>::value,
+	                                  long long, double>::type type;
+	typedef typename std::conditional<std::is_integral<T>::value,
+	                                  unsigned long long, double>::type store;
+};
+
+struct link {
+	link *prev;
+	link *next;
+};
+
+template <typename T>
+struct node : link {
+	T num;
+};
+
+} /* namespace detail */
+
+
+/**
+ * statistics policies. each policy exposes a `state<T, List>` mixin that
+ * flist<> inherits from; `add`/`remove` are called once per inserted/removed
+ * element and are empty inline functions for measures that are not tracked,
+ * so they compile away entirely.
+ */
+
+/* track nothing */
+struct no_stats {
+	template <typename T, typename List>
+	class state {
+	protected:
+		void add_(T) {}
+		void remove_(T) {}
+		void clear_() {}
+	};
+};
+
+/* track sum and mean */
+struct sum_stats {
+	template <typename T, typename List>
+	class state {
+	public:
+		typedef typename detail::accum<T>::type sum_type;
+
+		sum_type sum() const { return static_cast<sum_type>(sum_); }
+		double mean() const
+		{
+			std::size_t n = static_cast<const List *>(this)->size();
+			return n ? static_cast<double>(sum()) / n : 0;
+		}
+
+	protected:
+		void add_(T n) { sum_ += static_cast<store_type>(n); }
+		void remove_(T n) { sum_ -= static_cast<store_type>(n); }
+		void clear_() { sum_ = 0; }
+
+	private:
+		typedef typename detail::accum<T>::store store_type;
+		store_type sum_ = 0;
+	};
+};
+
+/*
+ * track sum and sumsq, giving mean, variance and std_dev. the variance comes
+ * from the running sum of squared deviations (Welford), which does not
+ * cancel the way sumsq / n - mean^2 does when the mean is large.
+ */
+struct variance_stats {
+	template <typename T, typename List>
+	class state : public sum_stats::state<T, List> {
+		typedef sum_stats::state<T, List> base;
+	public:
+		double sumsq() const { return sumsq_; }
+
+		double variance() const
+		{
+			std::size_t n = static_cast<const List *>(this)->size();
+			return n ? m2_ / n : 0;
+		}
+		double std_dev() const { return std::sqrt(variance()); }
+
+	protected:
+		void add_(T n)
+		{
+			base::add_(n);
+			sumsq_ += static_cast<double>(n) * n;
+			double x = static_cast<double>(n);
+			double d = x - mean_;
+			mean_ += d / static_cast<const List *>(this)->size();
+			m2_ += d * (x - mean_);
+		}
+		void remove_(T n)
+		{
+			base::remove_(n);
+			sumsq_ -= static_cast<double>(n) * n;
+			std::size_t len = static_cast<const List *>(this)->size();
+			if (len == 0) {
+				mean_ = 0;
+				m2_ = 0;
+				return;
+			}
+			double x = static_cast<double>(n);
+			double d = x - mean_;
+			mean_ -= d / len;
+			m2_ -= d * (x - mean_);
+			if (m2_ < 0)
+				m2_ = 0;
+		}
+		void clear_()
+		{
+			base::clear_();
+			sumsq_ = 0;
+			mean_ = 0;
+			m2_ = 0;
+		}
+
+	private:
+		double sumsq_ = 0;
+		/* running mean and sum of squared deviations from it */
+		double mean_ = 0;
+		double m2_ = 0;
+	};
+};
+
+/**
+ * track min and max. insertion is O(1); removing the current extreme marks it
+ * stale and the next min()/max() call rescans the list once.
+ */
+struct minmax_stats {
+	template <typename T, typename List>
+	class state {
+	public:
+		T min() const { refresh_(); return min_; }
+		T max() const { refresh_(); return max_; }
+
+	protected:
+		void add_(T n)
+		{
+			if (stale_)
+				return;
+			if (empty_) {
+				min_ = max_ = n;
+				empty_ = false;
+				return;
+			}
+			if (n < min_) min_ = n;
+			if (n > max_) max_ = n;
+		}
+		void remove_(T n)
+		{
+			if (!stale_ && (!(min_ < n) || !(n < max_)))
+				stale_ = true;
+		}
+		void clear_()
+		{
+			empty_ = true;
+			stale_ = false;
+			min_ = max_ = T();
+		}
+
+	private:
+		void refresh_() const
+		{
+			if (!stale_)
+				return;
+			const List *l = static_cast<const List *>(this);
+			empty_ = true;
+			min_ = max_ = T();
+			for (typename List::const_iterator it = l->begin(); it != l->end(); ++it) {
+				if (empty_) {
+					min_ = max_ = *it;
+					empty_ = false;
+				}
+				if (*it < min_) min_ = *it;
+				if (*it > max_) max_ = *it;
+			}
+			stale_ = false;
+		}
+
+		mutable T min_ = T();
+		mutable T max_ = T();
+		mutable bool empty_ = true;
+		mutable bool stale_ = false;
+	};
+};
+
+namespace detail {
+
+/* true if a policy of `Ps` other than `P` already carries the state of `P`, e.g. variance_stats for sum_stats */
+template <typename T, typename List, typename P, typename... Ps>
+struct carried : std::false_type {};
+
+template <typename T, typename List, typename P, typename Q, typename... Ps>
+struct carried<T, List, P, Q, Ps...>
+	: std::integral_constant<bool,
+	  (!std::is_same<P, Q>::value
+	   && std::is_base_of<typename P::template state<T, List>,
+	                      typename Q::template state<T, List> >::value)
+	  || carried<T, List, P, Ps...>::value> {};
+
+/* stand-in for the state of policy `P` when another policy carries it */
+template <typename P, typename T>
+class carried_state {
+protected:
+	void add_(T) {}
+	void remove_(T) {}
+	void clear_() {}
+};
+
+template <typename T, typename List, typename P, typename... Ps>
+struct stats_base {
+	typedef typename std::conditional<carried<T, List, P, Ps...>::value,
+	                                  carried_state<P, T>,
+	                                  typename P::template state<T, List> >::type type;
+};
+
+} /* namespace detail */
+
+/**
+ * combine any number of the policies above, e.g. stats<variance_stats, minmax_stats>.
+ * a policy whose state another one already includes is dropped, so
+ * stats<sum_stats, variance_stats> tracks the sum once. list each policy once.
+ */
+template <typename... Policies>
+struct stats {
+	template <typename T, typename List>
+	class state : public detail::stats_base<T, List, Policies, Policies...>::type... {
+	protected:
+		void add_(T n) { int x[] = {0, (detail::stats_base<T, List, Policies, Policies...>::type::add_(n), 0)...}; (void) x; }
+		void remove_(T n) { int x[] = {0, (detail::stats_base<T, List, Policies, Policies...>::type::remove_(n), 0)...}; (void) x; }
+		void clear_() { int x[] = {0, (detail::stats_base<T, List, Policies, Policies...>::type::clear_(), 0)...}; (void) x; }
+	};
+};
+
+
+template <typename T, typename Stats = variance_stats, typename Alloc = std::allocator<T> >
+class flist : public Stats::template state<T, flist<T, Stats, Alloc> > {
+	static_assert(std::is_arithmetic<T>::value, "flist elements must be numeric");
+
+	typedef typename Stats::template state<T, flist> stats_base;
+	typedef detail::link link;
+	typedef detail::node<T> node;
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<node> node_alloc;
+	typedef std::allocator_traits<node_alloc> node_traits;
+
+public:
+	typedef T value_type;
+	typedef Alloc allocator_type;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef T &reference;
+	typedef const T &const_reference;
+	typedef T *pointer;
+	typedef const T *const_pointer;
+
+	template <bool Const>
+	class basic_iterator {
+		friend class flist;
+		typedef typename std::conditional<Const, const link *, link *>::type link_ptr;
+		typedef typename std::conditional<Const, const node *, node *>::type node_ptr;
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef T value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef typename std::conditional<Const, const T *, T *>::type pointer;
+		typedef typename std::conditional<Const, const T &, T &>::type reference;
+
+		basic_iterator() : nd_(nullptr) {}
+		explicit basic_iterator(link_ptr nd) : nd_(nd) {}
+		/* iterator -> const_iterator */
+		template <bool C, typename = typename std::enable_if<Const && !C>::type>
+		basic_iterator(const basic_iterator<C> &it) : nd_(it.nd_) {}
+
+		reference operator*() const { return static_cast<node_ptr>(nd_)->num; }
+		pointer operator->() const { return &static_cast<node_ptr>(nd_)->num; }
+		basic_iterator &operator++() { nd_ = nd_->next; return *this; }
+		basic_iterator operator++(int) { basic_iterator t = *this; nd_ = nd_->next; return t; }
+		basic_iterator &operator--() { nd_ = nd_->prev; return *this; }
+		basic_iterator operator--(int) { basic_iterator t = *this; nd_ = nd_->prev; return t; }
+		friend bool operator==(const basic_iterator &a, const basic_iterator &b) { return a.nd_ == b.nd_; }
+		friend bool operator!=(const basic_iterator &a, const basic_iterator &b) { return a.nd_ != b.nd_; }
+
+	private:
+		template <bool> friend class basic_iterator;
+		link_ptr nd_;
+	};
+
+	typedef basic_iterator<false> iterator;
+	typedef basic_iterator<true> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	/* construction, copy, move */
+
+	flist() : alloc_(), len_(0) { reset_(); }
+	explicit flist(const Alloc &a) : alloc_(a), len_(0) { reset_(); }
+
+	flist(std::initializer_list<T> init, const Alloc &a = Alloc()) : alloc_(a), len_(0)
+	{
+		reset_();
+		for (T n : init)
+			append(n);
+	}
+
+	flist(const flist &o)
+		: stats_base(),
+		  alloc_(node_traits::select_on_container_copy_construction(o.alloc_)),
+		  len_(0)
+	{
+		reset_();
+		for (T n : o)
+			append(n);
+	}
+
+	flist(flist &&o) noexcept : stats_base(o), alloc_(std::move(o.alloc_)), len_(0)
+	{
+		reset_();
+		steal_(o);
+	}
+
+	flist &operator=(const flist &o)
+	{
+		if (this == &o)
+			return *this;
+		clear();
+		if (node_traits::propagate_on_container_copy_assignment::value)
+			alloc_ = o.alloc_;
+		for (T n : o)
+			append(n);
+		return *this;
+	}
+
+	flist &operator=(flist &&o) noexcept(node_traits::propagate_on_container_move_assignment::value
+	                                     || std::is_empty<node_alloc>::value)
+	{
+		if (this == &o)
+			return *this;
+		clear();
+		if (node_traits::propagate_on_container_move_assignment::value) {
+			move_alloc_(o, std::integral_constant<bool,
+			            node_traits::propagate_on_container_move_assignment::value>());
+		} else if (!(alloc_ == o.alloc_)) {
+			/* allocators differ and may not be swapped: move element-wise */
+			for (T n : o)
+				append(n);
+			o.clear();
+			return *this;
+		}
+		stats_base::operator=(o);
+		steal_(o);
+		return *this;
+	}
+
+	~flist() { clear(); }
+
+	allocator_type get_allocator() const { return allocator_type(alloc_); }
+
+	/* iteration */
+
+	iterator begin() { return iterator(ring_.next); }
+	iterator end() { return iterator(&ring_); }
+	const_iterator begin() const { return const_iterator(ring_.next); }
+	const_iterator end() const { return const_iterator(&ring_); }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+	reverse_iterator rbegin() { return reverse_iterator(end()); }
+	reverse_iterator rend() { return reverse_iterator(begin()); }
+	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	/* O(1) accessors */
+
+	size_type size() const { return len_; }
+	size_type len() const { return len_; }
+	bool empty() const { return len_ == 0; }
+	T &head() { return as_node_(ring_.next)->num; }
+	T &tail() { return as_node_(ring_.prev)->num; }
+	const T &head() const { return as_node_(ring_.next)->num; }
+	const T &tail() const { return as_node_(ring_.prev)->num; }
+	T &front() { return head(); }
+	T &back() { return tail(); }
+	const T &front() const { return head(); }
+	const T &back() const { return tail(); }
+
+	/* append to flist in O(1) */
+	void append(T n) { link_before_(&ring_, make_node_(n)); }
+
+	/* add element to beginning of flist in O(1) (stack) */
+	void push(T n) { link_before_(ring_.next, make_node_(n)); }
+
+	/* remove head element and return it in O(1) (stack). list must be non-empty */
+	T pop() { return unlink_(ring_.next); }
+
+	/* remove tail element and return it in O(1) (queue). list must be non-empty */
+	T dequeue() { return unlink_(ring_.prev); }
+
+	void push_back(T n) { append(n); }
+	void push_front(T n) { push(n); }
+	void pop_front() { pop(); }
+	void pop_back() { dequeue(); }
+
+	/* insert `n` before `pos` in O(1), returning an iterator to the new element */
+	iterator insert(const_iterator pos, T n)
+	{
+		node *nd = make_node_(n);
+		link_before_(const_cast<link *>(pos.nd_), nd);
+		return iterator(nd);
+	}
+
+	/* remove element at `pos` in O(1), returning an iterator to the following element */
+	iterator erase(const_iterator pos)
+	{
+		link *nxt = pos.nd_->next;
+		unlink_(const_cast<link *>(pos.nd_));
+		return iterator(nxt);
+	}
+
+	/**
+	 * returns an iterator to the 0-indexed k-th element in O(N); traversal
+	 * begins at tail if `k` is past the midpoint, so at most N/2 steps
+	 */
+	iterator get_kth(size_type k)
+	{
+		if (k >= len_)
+			return end();
+		link *nd;
+		if (k > len_ / 2) {
+			nd = ring_.prev;
+			for (size_type i = len_ - 1; i > k; i--)
+				nd = nd->prev;
+		} else {
+			nd = ring_.next;
+			for (size_type i = 0; i < k; i++)
+				nd = nd->next;
+		}
+		return iterator(nd);
+	}
+
+	/* inserts `n` at index `k` in O(N), at most N/2 steps */
+	iterator insert_index(size_type k, T n)
+	{
+		return insert(k >= len_ ? end() : get_kth(k), n);
+	}
+
+	/* remove element at index `k` in O(N), at most N/2 steps */
+	void remove_index(size_type k)
+	{
+		if (k < len_)
+			erase(get_kth(k));
+	}
+
+	/* search for a value and return an iterator to it, or end(). O(N) */
+	iterator find(T n)
+	{
+		for (iterator it = begin(); it != end(); ++it)
+			if (near_(*it, n))
+				return it;
+		return end();
+	}
+
+	/* remove the first element equal to `n`; returns whether one was found */
+	bool remove(T n)
+	{
+		iterator it = find(n);
+		if (it == end())
+			return false;
+		erase(it);
+		return true;
+	}
+
+	/* reverses flist in O(N) via pointers, not vals */
+	void reverse()
+	{
+		link *nd = &ring_;
+		do {
+			std::swap(nd->prev, nd->next);
+			nd = nd->prev;
+		} while (nd != &ring_);
+	}
+
+	/* sort elements in O(N log N) by relinking nodes (merge sort); stats are unchanged */
+	void sort()
+	{
+		if (len_ < 2)
+			return;
+		ring_.prev->next = nullptr;
+		link *hd = merge_sort_(ring_.next);
+		/* restore prev links and close the ring */
+		link *prev = &ring_;
+		for (link *nd = hd; nd != nullptr; nd = nd->next) {
+			nd->prev = prev;
+			prev->next = nd;
+			prev = nd;
+		}
+		prev->next = &ring_;
+		ring_.prev = prev;
+	}
+
+	bool is_sorted() const
+	{
+		for (const link *nd = ring_.next; nd != &ring_ && nd->next != &ring_; nd = nd->next)
+			if (as_node_(nd->next)->num < as_node_(nd)->num)
+				return false;
+		return true;
+	}
+
+	/* delete all elements in O(N) */
+	void clear()
+	{
+		link *nd = ring_.next;
+		while (nd != &ring_) {
+			link *nxt = nd->next;
+			destroy_node_(static_cast<node *>(nd));
+			nd = nxt;
+		}
+		reset_();
+		len_ = 0;
+		this->clear_();
+	}
+
+	/* element-wise comparison using fl_near() semantics for floating point */
+	friend bool operator==(const flist &l, const flist &m)
+	{
+		if (l.len_ != m.len_)
+			return false;
+		const_iterator a = l.begin(), b = m.begin();
+		for (; a != l.end(); ++a, ++b)
+			if (!near_(*a, *b))
+				return false;
+		return true;
+	}
+	friend bool operator!=(const flist &l, const flist &m) { return !(l == m); }
+
+private:
+	static constexpr double epsilon_ = 1e-9;
+
+	/* mirrors fl_near(): relative epsilon, absolute near zero; exact for integers */
+	template <typename U>
+	static typename std::enable_if<std::is_integral<U>::value, bool>::type
+	near_(U a, U b) { return a == b; }
+
+	template <typename U>
+	static typename std::enable_if<!std::is_integral<U>::value, bool>::type
+	near_(U a, U b)
+	{
+		double diff = std::fabs(static_cast<double>(a) - b);
+		double d = std::fmax(std::fabs(static_cast<double>(a)), std::fabs(static_cast<double>(b)));
+		double rel_cmp = d * epsilon_;
+		if (epsilon_ > rel_cmp)
+			return diff <= epsilon_;
+		return diff <= rel_cmp;
+	}
+
+	static node *as_node_(link *l) { return static_cast<node *>(l); }
+	static const node *as_node_(const link *l) { return static_cast<const node *>(l); }
+
+	void reset_()
+	{
+		ring_.prev = &ring_;
+		ring_.next = &ring_;
+	}
+
+	node *make_node_(T n)
+	{
+		node *nd = node_traits::allocate(alloc_, 1);
+		node_traits::construct(alloc_, nd);
+		nd->num = n;
+		return nd;
+	}
+
+	void destroy_node_(node *nd)
+	{
+		node_traits::destroy(alloc_, nd);
+		node_traits::deallocate(alloc_, nd, 1);
+	}
+
+	void link_before_(link *pos, node *nd)
+	{
+		nd->next = pos;
+		nd->prev = pos->prev;
+		pos->prev->next = nd;
+		pos->prev = nd;
+		len_++;
+		this->add_(nd->num);
+	}
+
+	T unlink_(link *l)
+	{
+		node *nd = as_node_(l);
+		T ret = nd->num;
+		nd->prev->next = nd->next;
+		nd->next->prev = nd->prev;
+		len_--;
+		this->remove_(ret);
+		destroy_node_(nd);
+		return ret;
+	}
+
+	/* take over the ring of `o`, leaving it empty */
+	void steal_(flist &o)
+	{
+		if (o.len_ == 0)
+			return;
+		ring_.next = o.ring_.next;
+		ring_.prev = o.ring_.prev;
+		ring_.next->prev = &ring_;
+		ring_.prev->next = &ring_;
+		len_ = o.len_;
+		o.reset_();
+		o.len_ = 0;
+		o.clear_();
+	}
+
+	void move_alloc_(flist &o, std::true_type) { alloc_ = std::move(o.alloc_); }
+	void move_alloc_(flist &, std::false_type) {}
+
+	/* singly-linked merge sort on `next` pointers, used by sort() */
+	static link *merge_sort_(link *hd)
+	{
+		if (hd == nullptr || hd->next == nullptr)
+			return hd;
+		link *fast = hd, *slow = hd;
+		while (fast->next && fast->next->next) {
+			fast = fast->next->next;
+			slow = slow->next;
+		}
+		link *second = slow->next;
+		slow->next = nullptr;
+		link *a = merge_sort_(hd);
+		link *b = merge_sort_(second);
+
+		link head;
+		link *last = &head;
+		while (a && b) {
+			/* `<=` keeps the sort stable */
+			if (!(as_node_(b)->num < as_node_(a)->num)) {
+				last->next = a;
+				a = a->next;
+			} else {
+				last->next = b;
+				b = b->next;
+			}
+			last = last->next;
+		}
+		last->next = a ? a : b;
+		return head.next;
+	}
+
+	link ring_;
+	node_alloc alloc_;
+	size_type len_;
+};
+
+} /* namespace fl */
+
+#endif
@@ -0,0 +1,416 @@
+/**
+ * out-of-core sort (see flist_extsort.h).
+ *
+ * @nolan-h-hamilton
+ */
+
+/* mkstemp(), fdopen() */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "flist.h"
+#include "flist_extsort.h"
+
+
+/* doubles per buffered block when reading or writing a run */
+#define FL_EXT_BLOCK 4096
+
+
+/* where the elements come from: an flist (if `f` is NULL) or a dump */
+typedef struct {
+	fl_iter_type it;
+	FILE *f;
+} fl_ext_src_;
+
+/* where the sorted elements go: an flist (if `f` is NULL) or a dump */
+typedef struct {
+	flist l;
+	FILE *f;
+} fl_ext_dst_;
+
+/* a run being merged and its current block */
+typedef struct {
+	FILE *f;
+	double *buf;
+	size_t n;
+	size_t pos;
+} fl_ext_run_;
+
+
+static int fl_ext_cmp_(const void * a, const void * b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+
+static size_t fl_ext_read_(fl_ext_src_ * src, double * buf, size_t n)
+{
+	if (src->f != NULL)
+		return fread(buf, sizeof(double), n, src->f);
+	size_t i = 0;
+	while (i < n && fl_iter_next(&src->it, &buf[i]))
+		i++;
+	return i;
+}
+
+
+static int fl_ext_write_(fl_ext_dst_ * dst, const double * buf, size_t n)
+{
+	if (dst->f != NULL)
+		return fwrite(buf, sizeof(double), n, dst->f) == n;
+	for (size_t i = 0; i < n; i++)
+		if (fl_append(dst->l, buf[i]) == NULL)
+			return 0;
+	return 1;
+}
+
+
+/* anonymous temporary file in `tmpdir`, removed once closed */
+static FILE * fl_ext_tmp_(const char * tmpdir)
+{
+	if (tmpdir == NULL)
+		return tmpfile();
+
+	size_t len = strlen(tmpdir) + sizeof("/flist_runXXXXXX");
+	char *path = (char *) malloc(len);
+	if (path == NULL)
+		return NULL;
+	snprintf(path, len, "%s/flist_runXXXXXX", tmpdir);
+	FILE *f = NULL;
+	int fd = mkstemp(path);
+	if (fd >= 0) {
+		unlink(path);
+		f = fdopen(fd, "w+b");
+		if (f == NULL)
+			close(fd);
+	}
+	free(path);
+	return f;
+}
+
+
+/* restore the heap order of runs h[0..n) from index `i` down, smallest current element first */
+static void fl_ext_heap_down_(fl_ext_run_ ** h, int n, int i)
+{
+	for (;;) {
+		int min = i;
+		int c = 2*i + 1;
+		if (c < n && h[c]->buf[h[c]->pos] < h[min]->buf[h[min]->pos])
+			min = c;
+		if (c + 1 < n && h[c + 1]->buf[h[c + 1]->pos] < h[min]->buf[h[min]->pos])
+			min = c + 1;
+		if (min == i)
+			return;
+		fl_ext_run_ *tmp = h[i];
+		h[i] = h[min];
+		h[min] = tmp;
+		i = min;
+	}
+}
+
+
+/*
+ * merge the `k` run files `files` (each rewound) into `dst` through blocks of
+ * `block` doubles, closing the files. returns 1 on success.
+ */
+static int fl_ext_merge_(FILE ** files, int k, fl_ext_dst_ * dst, size_t block)
+{
+	int ok = 0;
+	int n = 0;
+	fl_ext_run_ *runs = (fl_ext_run_ *) calloc(k, sizeof(fl_ext_run_));
+	fl_ext_run_ **h = (fl_ext_run_ **) malloc(sizeof(fl_ext_run_ *) * k);
+	double *out = (double *) malloc(sizeof(double) * block);
+	if (runs == NULL || h == NULL || out == NULL)
+		goto done;
+
+	for (int i = 0; i < k; i++) {
+		runs[i].f = files[i];
+		runs[i].buf = (double *) malloc(sizeof(double) * block);
+		if (runs[i].buf == NULL)
+			goto done;
+		runs[i].n = fread(runs[i].buf, sizeof(double), block, files[i]);
+		if (runs[i].n > 0)
+			h[n++] = &runs[i];
+	}
+	for (int i = n/2 - 1; i >= 0; i--)
+		fl_ext_heap_down_(h, n, i);
+
+	size_t used = 0;
+	while (n > 0) {
+		fl_ext_run_ *r = h[0];
+		out[used++] = r->buf[r->pos++];
+		if (used == block) {
+			if (!fl_ext_write_(dst, out, used))
+				goto done;
+			used = 0;
+		}
+		if (r->pos == r->n) {
+			r->pos = 0;
+			r->n = fread(r->buf, sizeof(double), block, r->f);
+			if (r->n == 0)
+				h[0] = h[--n];
+		}
+		fl_ext_heap_down_(h, n, 0);
+	}
+	/* nothing is left over when the output filled whole blocks */
+	ok = used == 0 || fl_ext_write_(dst, out, used);
+
+done:
+	for (int i = 0; i < k; i++) {
+		if (runs != NULL) {
+			if (ferror(files[i]))
+				ok = 0;
+			free(runs[i].buf);
+		}
+		fclose(files[i]);
+	}
+	free(runs);
+	free(h);
+	free(out);
+	return ok;
+}
+
+
+/*
+ * sort the elements of `src` into `dst` with at most `mem` bytes of buffers:
+ * sorted runs of mem / sizeof(double) elements are spilled to temporary
+ * files, then merged with one block of FL_EXT_BLOCK doubles per run and one
+ * for the output, in several passes if there are more runs than that allows.
+ * input that fits in one buffer is sorted in memory. returns 1 on success.
+ */
+static int fl_ext_sort_(fl_ext_src_ * src, fl_ext_dst_ * dst, size_t mem, const char * tmpdir, const char * name)
+{
+	if (mem == 0)
+		mem = FL_EXT_MEM;
+	size_t cap = mem / sizeof(double);
+	if (cap < FL_EXT_BLOCK)
+		cap = FL_EXT_BLOCK;
+	int fanin = (int) (cap / FL_EXT_BLOCK) - 1;
+	if (fanin < 2)
+		fanin = 2;
+
+	double *buf = (double *) malloc(sizeof(double) * cap);
+	if (buf == NULL) {
+		printf("\n%s(): memory allocation for sort buffer failed\n", name);
+		return 0;
+	}
+
+	/* spill sorted runs */
+	FILE **runs = NULL;
+	int nruns = 0;
+	int ok = 1;
+	for (;;) {
+		size_t n = fl_ext_read_(src, buf, cap);
+		if (src->f != NULL && ferror(src->f)) {
+			printf("\n%s(): reading the input failed\n", name);
+			ok = 0;
+			break;
+		}
+		if (n == 0)
+			break;
+		qsort(buf, n, sizeof(double), fl_ext_cmp_);
+		if (nruns == 0 && n < cap) {
+			ok = fl_ext_write_(dst, buf, n);
+			break;
+		}
+		FILE **grown = (FILE **) realloc(runs, sizeof(FILE *) * (nruns + 1));
+		FILE *f = fl_ext_tmp_(tmpdir);
+		if (grown != NULL)
+			runs = grown;
+		if (grown == NULL || f == NULL) {
+			printf("\n%s(): cannot create a temporary file for run %d\n", name, nruns);
+			if (f != NULL)
+				fclose(f);
+			ok = 0;
+			break;
+		}
+		runs[nruns++] = f;
+		if (fwrite(buf, sizeof(double), n, f) != n || fflush(f) != 0) {
+			printf("\n%s(): writing run %d failed\n", name, nruns - 1);
+			ok = 0;
+			break;
+		}
+		rewind(f);
+		if (n < cap)
+			break;
+	}
+	free(buf);
+	if (!ok) {
+		for (int i = 0; i < nruns; i++)
+			fclose(runs[i]);
+		free(runs);
+		return 0;
+	}
+
+	/* merge `fanin` runs at a time into a new run until one pass is enough */
+	while (nruns > fanin) {
+		FILE *f = fl_ext_tmp_(tmpdir);
+		fl_ext_dst_ tmp = {NULL, f};
+		if (f == NULL || !fl_ext_merge_(runs, fanin, &tmp, FL_EXT_BLOCK)
+		    || fflush(f) != 0) {
+			printf("\n%s(): intermediate merge failed\n", name);
+			if (f != NULL)
+				fclose(f);
+			/* the first `fanin` runs are closed by now, or were never merged */
+			for (int i = f == NULL ? 0 : fanin; i < nruns; i++)
+				fclose(runs[i]);
+			free(runs);
+			return 0;
+		}
+		rewind(f);
+		memmove(runs, runs + fanin, sizeof(FILE *) * (nruns - fanin));
+		nruns -= fanin;
+		runs[nruns++] = f;
+	}
+	if (nruns > 0 && !fl_ext_merge_(runs, nruns, dst, FL_EXT_BLOCK)) {
+		printf("\n%s(): merge failed\n", name);
+		ok = 0;
+	}
+	free(runs);
+	return ok;
+}
+
+
+/**
+ * sorted copy of `l` as a new flist (with the run-length layout of `l`),
+ * sorting out of core: at most `mem` bytes (0: FL_EXT_MEM) of buffers are
+ * used next to the two lists, spilling sorted runs to temporary files in
+ * `tmpdir` (NULL: the system default). O(N log N) comparisons, and
+ * O(N log_k(N / mem)) sequential I/O with k = mem / 32 KB.
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_ext_sort(flist l, size_t mem, const char * tmpdir)
+{
+	if (l == NULL) {
+		printf("\nfl_ext_sort(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	flist out = fl_make_flist();
+	if (out == NULL)
+		return NULL;
+	fl_set_rle(out, l->rle);
+
+	fl_ext_src_ src;
+	src.f = NULL;
+	fl_iter_at(l, 0, &src.it);
+	fl_ext_dst_ dst = {out, NULL};
+	if (!fl_ext_sort_(&src, &dst, mem, tmpdir, "fl_ext_sort")) {
+		fl_destroy(out);
+		free(out);
+		return NULL;
+	}
+	return out;
+}
+
+
+/**
+ * sort the dump `in_path` (see fl_ext_dump()) into a new dump `out_path`,
+ * which must be another file, with the memory budget and temporary directory
+ * of fl_ext_sort(). returns 1 on success, 0 on failure.
+ *
+ * @nolan-h-hamilton
+ */
+int fl_ext_sort_file(const char * in_path, const char * out_path, size_t mem, const char * tmpdir)
+{
+	if (in_path == NULL || out_path == NULL) {
+		printf("\nfl_ext_sort_file(): file name is NULL\n");
+		return 0;
+	}
+	fl_ext_src_ src;
+	src.f = fopen(in_path, "rb");
+	if (src.f == NULL) {
+		printf("\nfl_ext_sort_file(): cannot open %s\n", in_path);
+		return 0;
+	}
+	fl_ext_dst_ dst = {NULL, fopen(out_path, "wb")};
+	if (dst.f == NULL) {
+		printf("\nfl_ext_sort_file(): cannot open %s\n", out_path);
+		fclose(src.f);
+		return 0;
+	}
+	int ok = fl_ext_sort_(&src, &dst, mem, tmpdir, "fl_ext_sort_file");
+	fclose(src.f);
+	if (fclose(dst.f) != 0)
+		ok = 0;
+	return ok;
+}
+
+
+/**
+ * write the elements of `l` to the file `path` as raw native doubles, in
+ * order. returns 1 on success, 0 on failure.
+ *
+ * @nolan-h-hamilton
+ */
+int fl_ext_dump(flist l, const char * path)
+{
+	if (l == NULL || path == NULL) {
+		printf("\nfl_ext_dump(): flist `l` or file name is NULL\n");
+		return 0;
+	}
+	FILE *f = fopen(path, "wb");
+	if (f == NULL) {
+		printf("\nfl_ext_dump(): cannot open %s\n", path);
+		return 0;
+	}
+	double buf[FL_EXT_BLOCK];
+	fl_ext_src_ src;
+	src.f = NULL;
+	fl_iter_at(l, 0, &src.it);
+	fl_ext_dst_ dst = {NULL, f};
+	int ok = 1;
+	size_t n;
+	while (ok && (n = fl_ext_read_(&src, buf, FL_EXT_BLOCK)) > 0)
+		ok = fl_ext_write_(&dst, buf, n);
+	if (fclose(f) != 0)
+		ok = 0;
+	if (!ok)
+		printf("\nfl_ext_dump(): writing %s failed\n", path);
+	return ok;
+}
+
+
+/**
+ * new flist holding the elements of the dump `path`, or NULL on failure
+ *
+ * @nolan-h-hamilton
+ */
+flist fl_ext_load(const char * path)
+{
+	if (path == NULL) {
+		printf("\nfl_ext_load(): file name is NULL, returning NULL\n");
+		return NULL;
+	}
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		printf("\nfl_ext_load(): cannot open %s, returning NULL\n", path);
+		return NULL;
+	}
+	flist l = fl_make_flist();
+	double buf[FL_EXT_BLOCK];
+	fl_ext_src_ src;
+	src.f = f;
+	fl_ext_dst_ dst = {l, NULL};
+	int ok = l != NULL;
+	size_t n;
+	while (ok && (n = fl_ext_read_(&src, buf, FL_EXT_BLOCK)) > 0)
+		ok = fl_ext_write_(&dst, buf, n);
+	if (ferror(f))
+		ok = 0;
+	fclose(f);
+	if (!ok) {
+		printf("\nfl_ext_load(): reading %s failed, returning NULL\n", path);
+		if (l != NULL) {
+			fl_destroy(l);
+			free(l);
+		}
+		return NULL;
+	}
+	return l;
+}
@@ -0,0 +1,48 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+
+/**
+ * out-of-core sorting of flists and of binary dumps of them.
+ *
+ * fl_sort() needs the whole list resident and merges by chasing pointers all
+ * over the heap. fl_ext_sort() instead reads the elements in order into a
+ * buffer of at most `mem` bytes, spills each full buffer as a sorted run to
+ * a temporary file, and merges the runs back with a heap over one buffered
+ * block per run (in several passes if the budget does not allow a block for
+ * every run), so only sequential file I/O touches the data.
+ *
+ * a dump (see fl_ext_dump()) holds the elements as raw native doubles, in
+ * order and without a header.
+ *
+ * @nolan-h-hamilton
+ */
+
+
+#ifndef FLIST_EXTSORT_H_
+#define FLIST_EXTSORT_H_
+
+#include "flist.h"
+
+/* default memory budget of the sort buffers in bytes */
+#define FL_EXT_MEM (64 << 20)
+
+/* Functions */
+
+/*
+ * sorted copy of `l` as a new flist, using at most `mem` bytes of buffers
+ * (0: FL_EXT_MEM) and temporary files in `tmpdir` (NULL: the system default)
+ */
+flist fl_ext_sort(flist l, size_t mem, const char * tmpdir);
+
+/* sort the dump `in_path` into a new dump `out_path`, see fl_ext_sort(). returns 1 on success */
+int fl_ext_sort_file(const char * in_path, const char * out_path, size_t mem, const char * tmpdir);
+
+/* write the elements of `l` to `path` as raw native doubles. returns 1 on success */
+int fl_ext_dump(flist l, const char * path);
+
+/* new flist holding the elements of the dump `path` */
+flist fl_ext_load(const char * path);
+/*********************/
+
+#endif
@@ -0,0 +1,357 @@
+/**
+ * index-linked flist (see flist_idx.h).
+ *
+ * @nolan-h-hamilton
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "flist.h"
+#include "flist_idx.h"
+
+
+/**
+ * allocate memory for and initialize new flist_ix
+ *
+ * @nolan-h-hamilton
+ */
+flist_ix fl_ix_make_flist()
+{
+	flist_ix l = (flist_ix) calloc(1, sizeof(flist_ix_type));
+	if (l == NULL) {
+		printf("\nmemory allocation for flist_ix failed..returning NULL\n");
+		return NULL;
+	}
+	l->free_list = FL_IX_NIL;
+	l->head = FL_IX_NIL;
+	l->tail = FL_IX_NIL;
+	return l;
+}
+
+
+/**
+ * after a node has been removed or added, update mean, sum, len fields in
+ * constant time, like fl_update_measures()
+ *
+ * @nolan-h-hamilton
+ */
+flist_ix fl_ix_update_measures(flist_ix l, double n, int add)
+{
+	if (l == NULL) {
+		printf("\nfl_ix_update_measures(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+	fl_moments_type x = fl_moments_of(n, 1);
+	fl_moments_merge(&l->mom, &x, add);
+	l->len = l->mom.n;
+	l->sum = l->mom.sum;
+	l->sumsq = l->mom.sumsq;
+	l->mean = l->mom.mean;
+	l->variance = l->len > 0 ? l->mom.m2 / l->len : 0;
+	l->std_dev = sqrt(l->variance);
+	return l;
+}
+
+
+/* take a slot for a node holding `n` from the free list, growing the array if none is left */
+static uint32_t fl_ix_alloc_(flist_ix l, double n, const char * name)
+{
+	if (l->free_list == FL_IX_NIL) {
+		if (l->cap == FL_IX_NIL) {
+			printf("\n%s(): flist is full\n", name);
+			return FL_IX_NIL;
+		}
+		uint32_t cap = l->cap > 0 ? 2 * l->cap : 16;
+		if (cap < l->cap || cap == FL_IX_NIL)
+			cap = FL_IX_NIL;
+		fl_ix_node_type *nodes = (fl_ix_node_type *) realloc(l->nodes, sizeof(fl_ix_node_type) * (size_t) cap);
+		if (nodes == NULL) {
+			printf("\n%s(): memory allocation for nodes failed\n", name);
+			return FL_IX_NIL;
+		}
+		/* chain the new slots, lowest index first */
+		for (uint32_t i = l->cap; i < cap; i++)
+			nodes[i].next = i + 1 < cap ? i + 1 : FL_IX_NIL;
+		l->free_list = l->cap;
+		l->nodes = nodes;
+		l->cap = cap;
+	}
+	uint32_t i = l->free_list;
+	l->free_list = l->nodes[i].next;
+	l->nodes[i].num = n;
+	return i;
+}
+
+
+/* link new node `i` before node `at`, or as the only node if `l` is empty */
+static void fl_ix_link_(flist_ix l, uint32_t i, uint32_t at)
+{
+	fl_ix_node_type *nd = l->nodes;
+	if (l->len == 0) {
+		nd[i].prev = i;
+		nd[i].next = i;
+		l->head = i;
+		l->tail = i;
+		return;
+	}
+	nd[i].prev = nd[at].prev;
+	nd[i].next = at;
+	nd[nd[at].prev].next = i;
+	nd[at].prev = i;
+}
+
+
+flist_ix fl_ix_append(flist_ix l, double n)
+{
+	if (l == NULL) {
+		printf("\nfl_ix_append(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	uint32_t i = fl_ix_alloc_(l, n, "fl_ix_append");
+	if (i == FL_IX_NIL)
+		return NULL;
+	fl_ix_link_(l, i, l->head);
+	l->tail = i;
+	return fl_ix_update_measures(l, n, 1);
+}
+
+
+flist_ix fl_ix_push(flist_ix l, double n)
+{
+	if (l == NULL) {
+		printf("\nfl_ix_push(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	uint32_t i = fl_ix_alloc_(l, n, "fl_ix_push");
+	if (i == FL_IX_NIL)
+		return NULL;
+	fl_ix_link_(l, i, l->head);
+	l->head = i;
+	return fl_ix_update_measures(l, n, 1);
+}
+
+
+/* unlink node `i` from `l`, return its slot to the free list and its value */
+static double fl_ix_unlink_(flist_ix l, uint32_t i)
+{
+	fl_ix_node_type *nd = l->nodes;
+	double ret = nd[i].num;
+	if (l->len == 1) {
+		l->head = FL_IX_NIL;
+		l->tail = FL_IX_NIL;
+	} else {
+		nd[nd[i].prev].next = nd[i].next;
+		nd[nd[i].next].prev = nd[i].prev;
+		if (i == l->head)
+			l->head = nd[i].next;
+		if (i == l->tail)
+			l->tail = nd[i].prev;
+	}
+	nd[i].next = l->free_list;
+	l->free_list = i;
+	fl_ix_update_measures(l, ret, 0);
+	return ret;
+}
+
+
+double fl_ix_pop(flist_ix l)
+{
+	if (l == NULL || l->len == 0) {
+		printf("\nfl_ix_pop(): cannot pop empty flist\n");
+		exit(1);
+	}
+	return fl_ix_unlink_(l, l->head);
+}
+
+
+double fl_ix_dequeue(flist_ix l)
+{
+	if (l == NULL || l->len == 0) {
+		printf("\nfl_ix_dequeue(): cannot dequeue empty flist\n");
+		exit(1);
+	}
+	return fl_ix_unlink_(l, l->tail);
+}
+
+
+/**
+ * return the index of the node holding the 0-indexed k-th element, or
+ * FL_IX_NIL if out of range. begins traversal from tail if `k` is past the
+ * midpoint.
+ *
+ * @nolan-h-hamilton
+ */
+uint32_t fl_ix_get_kth(flist_ix l, int k)
+{
+	if (l == NULL || k < 0 || k >= l->len)
+		return FL_IX_NIL;
+	uint32_t i;
+	int j;
+	if (k > l->len / 2) {
+		i = l->tail;
+		for (j = l->len - 1; j > k; j--)
+			i = l->nodes[i].prev;
+	} else {
+		i = l->head;
+		for (j = 0; j < k; j++)
+			i = l->nodes[i].next;
+	}
+	return i;
+}
+
+
+uint32_t fl_ix_find(flist_ix l, double n)
+{
+	if (l == NULL || l->len == 0)
+		return FL_IX_NIL;
+	uint32_t i = l->head;
+	for (int j = 0; j < l->len; j++, i = l->nodes[i].next)
+		if (fl_near(l->nodes[i].num, n))
+			return i;
+	return FL_IX_NIL;
+}
+
+
+flist_ix fl_ix_insert_index(flist_ix l, int index, double n)
+{
+	if (l == NULL) {
+		printf("\nfl_ix_insert_index(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	if (index < 0 || index > l->len) {
+		printf("\nfl_ix_insert_index(): index does not exist\n");
+		return l;
+	}
+	if (index == 0)
+		return fl_ix_push(l, n);
+	if (index == l->len)
+		return fl_ix_append(l, n);
+
+	uint32_t at = fl_ix_get_kth(l, index);
+	uint32_t i = fl_ix_alloc_(l, n, "fl_ix_insert_index");
+	if (i == FL_IX_NIL)
+		return NULL;
+	fl_ix_link_(l, i, at);
+	return fl_ix_update_measures(l, n, 1);
+}
+
+
+/**
+ * insert `n` before the first larger element, so that a list built only with
+ * fl_ix_insert() stays sorted. O(N).
+ *
+ * @nolan-h-hamilton
+ */
+flist_ix fl_ix_insert(flist_ix l, double n)
+{
+	if (l == NULL) {
+		printf("\nfl_ix_insert(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	if (l->len == 0 || n < l->nodes[l->head].num)
+		return fl_ix_push(l, n);
+
+	uint32_t at = l->nodes[l->head].next;
+	while (at != l->head && l->nodes[at].num <= n)
+		at = l->nodes[at].next;
+	if (at == l->head)
+		return fl_ix_append(l, n);
+	uint32_t i = fl_ix_alloc_(l, n, "fl_ix_insert");
+	if (i == FL_IX_NIL)
+		return NULL;
+	fl_ix_link_(l, i, at);
+	return fl_ix_update_measures(l, n, 1);
+}
+
+
+flist_ix fl_ix_remove_index(flist_ix l, int index)
+{
+	if (l == NULL) {
+		printf("\nfl_ix_remove_index(): flist `l` is NULL...returning NULL\n");
+		return NULL;
+	}
+	uint32_t i = fl_ix_get_kth(l, index);
+	if (i == FL_IX_NIL) {
+		printf("\nfl_ix_remove_index(): index does not exist\n");
+		return NULL;
+	}
+	fl_ix_unlink_(l, i);
+	return l;
+}
+
+
+flist_ix fl_ix_remove(flist_ix l, double n)
+{
+	if (l == NULL) {
+		printf("\nfl_ix_remove(): flist if NULL...returning NULL\n");
+		return NULL;
+	}
+	uint32_t i = fl_ix_find(l, n);
+	if (i == FL_IX_NIL) {
+		printf("\nfl_ix_remove(): key not found in flist...\n");
+		return l;
+	}
+	fl_ix_unlink_(l, i);
+	return l;
+}
+
+
+/* reverses the ring via links, not values, in O(N) */
+flist_ix fl_ix_reverse(flist_ix l)
+{
+	if (l == NULL || l->len <= 1)
+		return l;
+	uint32_t i = l->head;
+	for (int j = 0; j < l->len; j++) {
+		uint32_t nxt = l->nodes[i].next;
+		l->nodes[i].next = l->nodes[i].prev;
+		l->nodes[i].prev = nxt;
+		i = nxt;
+	}
+	uint32_t head = l->head;
+	l->head = l->tail;
+	l->tail = head;
+	return l;
+}
+
+
+void fl_ix_destroy(flist_ix l)
+{
+	if (l == NULL) {
+		printf("\nfl_ix_destroy(): flist `l` does not exist...\n");
+		return;
+	}
+	free(l->nodes);
+	free(l);
+}
+
+
+double * fl_ix_to_arr(flist_ix l)
+{
+	if (l == NULL || l->len == 0)
+		return NULL;
+	double * arr = (double *) malloc(sizeof(double) * l->len);
+	if (arr == NULL) {
+		printf("\nfl_ix_to_arr(): memory allocation for array failed\n");
+		return NULL;
+	}
+	uint32_t i = l->head;
+	for (int j = 0; j < l->len; j++) {
+		arr[j] = l->nodes[i].num;
+		i = l->nodes[i].next;
+	}
+	return arr;
+}
+
+
+void fl_ix_from_arr(flist_ix l, const double * arr, int arr_len)
+{
+	if (l == NULL || arr == NULL) {
+		printf("\nfl_ix_from_arr(): flist `l` or array is NULL\n");
+		return;
+	}
+	for (int i = 0; i < arr_len; i++)
+		if (fl_ix_append(l, arr[i]) == NULL)
+			return;
+}
@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+
+/**
+ * flist_ix is an flist whose nodes live in one array owned by the list and
+ * link to each other by 32-bit indexes instead of pointers.
+ *
+ * an fl_node is 24 bytes (a double and two pointers) and malloc rounds it up
+ * to 32 with its header; an fl_ix node is 16 bytes and has no header, so
+ * large lists take half the memory. the ring is still doubly-linked and
+ * circular, with O(1) access to head and tail and the measures recomputed in
+ * constant time by every insertion and removal like those of flist. freed
+ * slots are reused through a free list, and the array doubles when full, so
+ * append/push/pop/dequeue are O(1) amortized. a node is referred to by its
+ * index, which stays valid while it is on the list.
+ *
+ * @nolan-h-hamilton
+ */
+
+
+#ifndef FLIST_IDX_H_
+#define FLIST_IDX_H_
+
+#include "flist.h"
+
+/* Structs */
+
+/* index of no node */
+#define FL_IX_NIL UINT32_MAX
+
+typedef struct {
+	double num;
+	uint32_t prev;
+	uint32_t next;
+} fl_ix_node_type;
+
+typedef struct {
+	/* nodes[0..cap), linked through `next` from `free_list` when unused */
+	fl_ix_node_type *nodes;
+	uint32_t cap;
+	uint32_t free_list;
+	uint32_t head;
+	uint32_t tail;
+	double mean;
+	double variance;
+	double std_dev;
+	double sumsq;
+	double sum;
+	int len;
+	/* compensated sums and central moments behind the measures, see fl_moments_merge() */
+	fl_moments_type mom;
+} flist_ix_type, *flist_ix;
+
+/***************/
+
+/* Functions */
+
+/*
+ * a subset of the flist API for plain lists: there is no sort, get, copy,
+ * equals, combine or iterator, and none of run-length storage, frozen
+ * segments, snapshots, fingerprints, lazy reversal or lazy transforms.
+ * nodes are returned as indexes into l->nodes. the functions behave like
+ * their fl_* counterparts except where noted: fl_ix_insert_index() accepts
+ * 0 <= index <= len and the new element always ends up at `index`, whereas
+ * fl_insert_index() rejects index len and appends for index len - 1; and
+ * fl_ix_reverse() relinks every node in O(N).
+ */
+
+flist_ix fl_ix_make_flist();
+
+flist_ix fl_ix_update_measures(flist_ix l, double n, int add);
+
+/* O(1) amortized */
+flist_ix fl_ix_append(flist_ix l, double n);
+
+/* O(1) amortized */
+flist_ix fl_ix_push(flist_ix l, double n);
+
+/* O(1) */
+double fl_ix_pop(flist_ix l);
+
+/* O(1) */
+double fl_ix_dequeue(flist_ix l);
+
+/* index of the node holding the k-th element, or FL_IX_NIL. O(k), k <= len/2 */
+uint32_t fl_ix_get_kth(flist_ix l, int k);
+
+/* index of the first node fl_near() `n`, or FL_IX_NIL */
+uint32_t fl_ix_find(flist_ix l, double n);
+
+/* insert `n` so that it becomes the element at `index`, 0 <= index <= len */
+flist_ix fl_ix_insert_index(flist_ix l, int index, double n);
+
+/* insert `n` before the first larger element. O(N) */
+flist_ix fl_ix_insert(flist_ix l, double n);
+
+flist_ix fl_ix_remove_index(flist_ix l, int index);
+
+/* remove the first element fl_near() `n` */
+flist_ix fl_ix_remove(flist_ix l, double n);
+
+/* O(N) */
+flist_ix fl_ix_reverse(flist_ix l);
+
+void fl_ix_destroy(flist_ix l);
+
+double * fl_ix_to_arr(flist_ix l);
+
+void fl_ix_from_arr(flist_ix l, const double * arr, int arr_len);
+/*********************/
+
+#endif
@@ -0,0 +1,332 @@
+/**
+ * paired-series flist (see flist_pair.h).
+ *
+ * @nolan-h-hamilton
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "flist.h"
+#include "flist_pair.h"
+
+
+/**
+ * allocate memory for and initialize new pair node
+ *
+ * @nolan-h-hamilton
+ */
+fl_pair_node fl_pair_make_node(double x, double y)
+{
+	fl_pair_node nd = (fl_pair_node) malloc(sizeof(fl_pair_node_type));
+	if (nd == NULL) {
+		printf("\nfl_pair_make_node(): memory allocation for node failed...returning NULL\n");
+		return NULL;
+	}
+	nd->x = x;
+	nd->y = y;
+	nd->prev = NULL;
+	nd->next = NULL;
+	return nd;
+}
+
+
+/**
+ * allocate memory for and initialize new flist_pair
+ *
+ * @nolan-h-hamilton
+ */
+flist_pair fl_pair_make_flist()
+{
+	flist_pair l = (flist_pair) calloc(1, sizeof(flist_pair_type));
+
+	if (l == NULL) {
+		printf("\nmemory allocation for flist_pair failed..returning NULL\n");
+		return NULL;
+	}
+	return l;
+}
+
+
+/**
+ * after a pair has been removed or added, update the sums and the measures
+ * derived from them in constant time. like fl_update_measures(), sums are
+ * compensated and the variances and covariance come from sums of (products
+ * of) deviations from the means, updated by Welford's method, which stays
+ * accurate when the values are large compared to their spread.
+ *
+ * @nolan-h-hamilton
+ */
+flist_pair fl_pair_update_measures(flist_pair l, double x, double y, int add)
+{
+	if (l == NULL) {
+		printf("\nfl_pair_update_measures(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+
+	if (!add && l->len <= 1) {
+		fl_pair_node head = l->head;
+		fl_pair_node tail = l->tail;
+		*l = (flist_pair_type) {0};
+		l->head = head;
+		l->tail = tail;
+		return l;
+	}
+	/* size of the pairs other than (x, y), before an addition or after a removal */
+	double m = add ? l->len : l->len - 1;
+	fl_moments_type px = fl_moments_of(x, 1);
+	fl_moments_type py = fl_moments_of(y, 1);
+	double dx = fl_moments_merge(&l->mom_x, &px, add);
+	double dy = fl_moments_merge(&l->mom_y, &py, add);
+	double dxy = dx * dy * m / (m + 1);
+	l->cxy = add ? l->cxy + dxy : l->cxy - dxy;
+	if (l->mom_x.n <= 1)
+		l->cxy = 0;
+	fl_kahan_add(&l->sum_xy, &l->sum_xy_c, add ? x*y : -x*y);
+
+	l->len = l->mom_x.n;
+	l->sum_x = l->mom_x.sum;
+	l->sum_y = l->mom_y.sum;
+	l->sumsq_x = l->mom_x.sumsq;
+	l->sumsq_y = l->mom_y.sumsq;
+	l->mean_x = l->mom_x.mean;
+	l->mean_y = l->mom_y.mean;
+	l->variance_x = l->mom_x.m2 / l->len;
+	l->variance_y = l->mom_y.m2 / l->len;
+	l->covariance = l->len > 1 ? l->cxy / l->len : 0;
+	if (l->variance_x > 0 && l->variance_y > 0)
+		l->correlation = l->covariance / sqrt(l->variance_x * l->variance_y);
+	else
+		l->correlation = 0;
+	l->slope = l->variance_x > 0 ? l->covariance / l->variance_x : 0;
+	l->intercept = l->mean_y - l->slope * l->mean_x;
+	return l;
+}
+
+
+/* link new node `nd` before `at` (at the tail if `at` is head or NULL) */
+static flist_pair fl_pair_link_(flist_pair l, fl_pair_node nd, fl_pair_node at)
+{
+	if (l->len == 0) {
+		l->head = nd;
+		l->tail = nd;
+		nd->next = nd;
+		nd->prev = nd;
+		return fl_pair_update_measures(l, nd->x, nd->y, 1);
+	}
+	if (at == NULL)
+		at = l->head;
+	nd->prev = at->prev;
+	nd->next = at;
+	at->prev->next = nd;
+	at->prev = nd;
+	if (at == l->head)
+		l->tail = nd;
+	return fl_pair_update_measures(l, nd->x, nd->y, 1);
+}
+
+
+/* unlink `nd` from `l`, free it and return its pair */
+static fl_xy fl_pair_unlink_(flist_pair l, fl_pair_node nd)
+{
+	fl_xy ret = {nd->x, nd->y};
+	if (l->len == 1) {
+		l->head = NULL;
+		l->tail = NULL;
+	} else {
+		nd->prev->next = nd->next;
+		nd->next->prev = nd->prev;
+		if (nd == l->head)
+			l->head = nd->next;
+		if (nd == l->tail)
+			l->tail = nd->prev;
+	}
+	fl_pair_update_measures(l, ret.x, ret.y, 0);
+	free(nd);
+	return ret;
+}
+
+
+flist_pair fl_pair_append(flist_pair l, double x, double y)
+{
+	if (l == NULL) {
+		printf("\nfl_pair_append(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	fl_pair_node nd = fl_pair_make_node(x, y);
+	if (nd == NULL)
+		return NULL;
+	return fl_pair_link_(l, nd, NULL);
+}
+
+
+flist_pair fl_pair_push(flist_pair l, double x, double y)
+{
+	if (fl_pair_append(l, x, y) == NULL)
+		return NULL;
+	/* the new tail becomes head by rotating the ring one step back */
+	l->head = l->tail;
+	l->tail = l->tail->prev;
+	return l;
+}
+
+
+fl_xy fl_pair_pop(flist_pair l)
+{
+	if (l == NULL || l->len == 0) {
+		printf("\nfl_pair_pop(): cannot pop empty flist\n");
+		exit(1);
+	}
+	return fl_pair_unlink_(l, l->head);
+}
+
+
+fl_xy fl_pair_dequeue(flist_pair l)
+{
+	if (l == NULL || l->len == 0) {
+		printf("\nfl_pair_dequeue(): cannot dequeue empty flist\n");
+		exit(1);
+	}
+	return fl_pair_unlink_(l, l->tail);
+}
+
+
+/**
+ * return the 0-indexed k-th node, or NULL if out of range.
+ * begins traversal from tail if `k` is past the midpoint.
+ *
+ * @nolan-h-hamilton
+ */
+fl_pair_node fl_pair_get_kth(flist_pair l, int k)
+{
+	if (l == NULL || l->len == 0 || k < 0 || k >= l->len)
+		return NULL;
+	fl_pair_node nd;
+	int i;
+	if (k > l->len / 2) {
+		nd = l->tail;
+		for (i = l->len - 1; i > k; i--)
+			nd = nd->prev;
+	} else {
+		nd = l->head;
+		for (i = 0; i < k; i++)
+			nd = nd->next;
+	}
+	return nd;
+}
+
+
+flist_pair fl_pair_insert_index(flist_pair l, int index, double x, double y)
+{
+	if (l == NULL) {
+		printf("\nfl_pair_insert_index(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	if (index < 0 || index > l->len) {
+		printf("\nfl_pair_insert_index(): index does not exist\n");
+		return l;
+	}
+	if (index == 0)
+		return fl_pair_push(l, x, y);
+
+	fl_pair_node nd = fl_pair_make_node(x, y);
+	if (nd == NULL)
+		return NULL;
+	return fl_pair_link_(l, nd, index == l->len ? NULL : fl_pair_get_kth(l, index));
+}
+
+
+/**
+ * insert (x, y) before the first pair with a larger x, so that a list built
+ * only with fl_pair_insert() stays sorted by x. O(N).
+ *
+ * @nolan-h-hamilton
+ */
+flist_pair fl_pair_insert(flist_pair l, double x, double y)
+{
+	if (l == NULL) {
+		printf("\nfl_pair_insert(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	if (l->len == 0 || x < l->head->x)
+		return fl_pair_push(l, x, y);
+
+	fl_pair_node nd = fl_pair_make_node(x, y);
+	if (nd == NULL)
+		return NULL;
+	fl_pair_node iter = l->head->next;
+	while (iter != l->head && iter->x <= x)
+		iter = iter->next;
+	return fl_pair_link_(l, nd, iter);
+}
+
+
+flist_pair fl_pair_remove_index(flist_pair l, int index)
+{
+	if (l == NULL) {
+		printf("\nfl_pair_remove_index(): flist `l` is NULL...returning NULL\n");
+		return NULL;
+	}
+	fl_pair_node nd = fl_pair_get_kth(l, index);
+	if (nd == NULL) {
+		printf("\nfl_pair_remove_index(): index does not exist\n");
+		return NULL;
+	}
+	fl_pair_unlink_(l, nd);
+	return l;
+}
+
+
+flist_pair fl_pair_remove(flist_pair l, double x, double y)
+{
+	if (l == NULL) {
+		printf("\nfl_pair_remove(): flist if NULL...returning NULL\n");
+		return NULL;
+	}
+
+	fl_pair_node nd = l->head;
+	for (int i = 0; i < l->len; i++, nd = nd->next) {
+		if (fl_near(nd->x, x) && fl_near(nd->y, y)) {
+			fl_pair_unlink_(l, nd);
+			return l;
+		}
+	}
+
+	printf("\nfl_pair_remove(): key not found in flist...\n");
+	return l;
+}
+
+
+void fl_pair_destroy(flist_pair l)
+{
+	if (l == NULL) {
+		printf("\nfl_pair_destroy(): flist `l` does not exist...\n");
+		return;
+	}
+	fl_pair_node nd = l->head;
+	for (int i = 0; i < l->len; i++) {
+		fl_pair_node cpy = nd->next;
+		free(nd);
+		nd = cpy;
+	}
+	free(l);
+}
+
+
+fl_xy * fl_pair_to_arr(flist_pair l)
+{
+	if (l == NULL || l->len == 0)
+		return NULL;
+	fl_xy * arr = (fl_xy *) malloc(sizeof(fl_xy) * l->len);
+	if (arr == NULL) {
+		printf("\nfl_pair_to_arr(): memory allocation for array failed\n");
+		return NULL;
+	}
+	fl_pair_node nd = l->head;
+	for (int i = 0; i < l->len; i++) {
+		arr[i].x = nd->x;
+		arr[i].y = nd->y;
+		nd = nd->next;
+	}
+	return arr;
+}
@@ -0,0 +1,108 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+
+/**
+ * flist_pair is an flist of (x, y) pairs for paired measurements.
+ *
+ * keeping x and y in two parallel flists gives their means and variances,
+ * but covariance and correlation need the cross term sum(x*y), which only a
+ * joint list can maintain. flist_pair keeps the doubly-linked, circular ring
+ * of flist with both values in each node, and its measures (sums, means,
+ * variances, covariance, Pearson correlation and the least-squares line
+ * y = slope*x + intercept) are recomputed in constant time by every insertion
+ * and removal, like those of flist.
+ *
+ * @nolan-h-hamilton
+ */
+
+
+#ifndef FLIST_PAIR_H_
+#define FLIST_PAIR_H_
+
+#include "flist.h"
+
+/* Structs */
+
+typedef struct {
+	double x;
+	double y;
+} fl_xy;
+
+typedef struct fl_pair_node {
+	double x;
+	double y;
+	struct fl_pair_node *prev;
+	struct fl_pair_node *next;
+} fl_pair_node_type, *fl_pair_node;
+
+typedef struct {
+	fl_pair_node head;
+	fl_pair_node tail;
+	int len;
+	double sum_x;
+	double sum_y;
+	double sumsq_x;
+	double sumsq_y;
+	double sum_xy;
+	double mean_x;
+	double mean_y;
+	double variance_x;
+	double variance_y;
+	double covariance;
+	/* 0 while either variance is 0 */
+	double correlation;
+	/* least-squares fit of y on x, 0 while variance_x is 0 */
+	double slope;
+	double intercept;
+	/* compensated sums and central moments of x and y, see fl_moments_merge() */
+	fl_moments_type mom_x;
+	fl_moments_type mom_y;
+	/* compensation term of sum_xy, and the sum of products of the deviations from the means */
+	double sum_xy_c;
+	double cxy;
+} flist_pair_type, *flist_pair;
+
+/***************/
+
+/* Functions */
+
+fl_pair_node fl_pair_make_node(double x, double y);
+
+flist_pair fl_pair_make_flist();
+
+/* after a pair has been removed or added, update the measures in O(1) */
+flist_pair fl_pair_update_measures(flist_pair l, double x, double y, int add);
+
+/* O(1) */
+flist_pair fl_pair_append(flist_pair l, double x, double y);
+
+/* O(1) */
+flist_pair fl_pair_push(flist_pair l, double x, double y);
+
+/* remove and return the head pair. O(1) */
+fl_xy fl_pair_pop(flist_pair l);
+
+/* remove and return the tail pair. O(1) */
+fl_xy fl_pair_dequeue(flist_pair l);
+
+/* O(k), k <= len/2 */
+fl_pair_node fl_pair_get_kth(flist_pair l, int k);
+
+/* insert (x, y) so that it becomes the pair at `index`, 0 <= index <= len */
+flist_pair fl_pair_insert_index(flist_pair l, int index, double x, double y);
+
+/* insert (x, y) before the first pair with a larger x. O(N) */
+flist_pair fl_pair_insert(flist_pair l, double x, double y);
+
+flist_pair fl_pair_remove_index(flist_pair l, int index);
+
+/* remove the first pair fl_near() (x, y) */
+flist_pair fl_pair_remove(flist_pair l, double x, double y);
+
+void fl_pair_destroy(flist_pair l);
+
+fl_xy * fl_pair_to_arr(flist_pair l);
+/*********************/
+
+#endif
@@ -0,0 +1,218 @@
+/**
+ * reservoir sampler with random pairing used by flist (see flist_sample.h).
+ *
+ * @nolan-h-hamilton
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "flist_sample.h"
+
+
+/* next output of the splitmix64 generator */
+static unsigned long long fl_sampler_rand_(fl_sampler s)
+{
+	unsigned long long z = (s->rng += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+
+/* uniform integer in [0, n), n > 0 */
+static long fl_sampler_below_(fl_sampler s, long n)
+{
+	return (long) (fl_sampler_rand_(s) % (unsigned long long) n);
+}
+
+
+/* home position of `item` in the index */
+static size_t fl_sampler_home_(fl_sampler s, void * item)
+{
+	return (size_t) (((uint64_t) (uintptr_t) item * 0x9e3779b97f4a7c15ULL) >> 32) & s->mask;
+}
+
+
+/* index entry holding `item`, or the empty entry where it would go */
+static size_t fl_sampler_find_(fl_sampler s, void * item)
+{
+	size_t i = fl_sampler_home_(s, item);
+	while (s->key[i] != NULL && s->key[i] != item)
+		i = (i + 1) & s->mask;
+	return i;
+}
+
+
+/* remove index entry `i`, shifting back the entries probed past it */
+static void fl_sampler_unindex_(fl_sampler s, size_t i)
+{
+	size_t j = i;
+	for (;;) {
+		j = (j + 1) & s->mask;
+		if (s->key[j] == NULL)
+			break;
+		size_t h = fl_sampler_home_(s, s->key[j]);
+		/* the entry at j may fill the hole unless its home lies in (i, j] */
+		if (i <= j ? (h <= i || h > j) : (h <= i && h > j)) {
+			s->key[i] = s->key[j];
+			s->pos[i] = s->pos[j];
+			i = j;
+		}
+	}
+	s->key[i] = NULL;
+}
+
+
+/* put `item` in slot `p`, which must be free or hold an item already unindexed */
+static void fl_sampler_put_(fl_sampler s, int p, void * item)
+{
+	size_t i = fl_sampler_find_(s, item);
+	s->slot[p] = item;
+	s->key[i] = item;
+	s->pos[i] = p;
+}
+
+
+/* drop the item in slot `p`, moving the last one into its place */
+static void fl_sampler_drop_(fl_sampler s, int p)
+{
+	fl_sampler_unindex_(s, fl_sampler_find_(s, s->slot[p]));
+	s->len--;
+	if (p < s->len) {
+		void *last = s->slot[s->len];
+		s->pos[fl_sampler_find_(s, last)] = p;
+		s->slot[p] = last;
+	}
+}
+
+
+/**
+ * allocate memory for and initialize a new, empty sampler
+ *
+ * @nolan-h-hamilton
+ */
+fl_sampler fl_sampler_make(int cap, unsigned long long seed)
+{
+	if (cap < 1) {
+		printf("\nfl_sampler_make(): need cap >= 1...returning NULL\n");
+		return NULL;
+	}
+
+	fl_sampler s = (fl_sampler) calloc(1, sizeof(fl_sampler_type));
+	if (s == NULL) {
+		printf("\nmemory allocation for sampler failed...returning NULL\n");
+		return NULL;
+	}
+	/* keep the index at most half full */
+	size_t size = 2;
+	while (size < 2 * (size_t) cap)
+		size *= 2;
+	s->slot = (void **) malloc(sizeof(void *) * cap);
+	s->key = (void **) calloc(size, sizeof(void *));
+	s->pos = (int *) malloc(sizeof(int) * size);
+	if (s->slot == NULL || s->key == NULL || s->pos == NULL) {
+		printf("\nmemory allocation for sampler failed...returning NULL\n");
+		fl_sampler_destroy(s);
+		return NULL;
+	}
+	s->cap = cap;
+	s->mask = size - 1;
+	s->rng = seed;
+	return s;
+}
+
+
+void fl_sampler_destroy(fl_sampler s)
+{
+	if (s == NULL)
+		return;
+	free(s->slot);
+	free(s->key);
+	free(s->pos);
+	free(s);
+}
+
+
+/**
+ * count a newly inserted item. while removals are unpaired, the item takes
+ * the place of a removed sampled one with probability in / (in + out), which
+ * is the chance that the removed item it pairs with was sampled; otherwise it
+ * goes through reservoir sampling over the `n` items.
+ *
+ * @nolan-h-hamilton
+ */
+void fl_sampler_insert(fl_sampler s, void * item, long n)
+{
+	if (s == NULL)
+		return;
+	if (s->in + s->out > 0) {
+		if (fl_sampler_below_(s, s->in + s->out) < s->in) {
+			s->in--;
+			fl_sampler_put_(s, s->len++, item);
+		} else {
+			s->out--;
+		}
+		return;
+	}
+	if (s->len < s->cap) {
+		fl_sampler_put_(s, s->len++, item);
+	} else if (fl_sampler_below_(s, n) < s->cap) {
+		int p = (int) fl_sampler_below_(s, s->cap);
+		fl_sampler_unindex_(s, fl_sampler_find_(s, s->slot[p]));
+		fl_sampler_put_(s, p, item);
+	}
+}
+
+
+void fl_sampler_remove(fl_sampler s, void * item)
+{
+	if (s == NULL)
+		return;
+	size_t i = fl_sampler_find_(s, item);
+	if (s->key[i] == NULL) {
+		s->out++;
+		return;
+	}
+	s->in++;
+	fl_sampler_drop_(s, s->pos[i]);
+}
+
+
+void fl_sampler_move(fl_sampler s, void * item, void * to)
+{
+	if (s == NULL || item == to)
+		return;
+	size_t i = fl_sampler_find_(s, item);
+	if (s->key[i] == NULL)
+		return;
+	int p = s->pos[i];
+	fl_sampler_unindex_(s, i);
+	fl_sampler_put_(s, p, to);
+}
+
+
+/**
+ * draw min(`k`, s->len) sampled items without replacement by a partial
+ * Fisher-Yates shuffle of the slots in O(k)
+ *
+ * @nolan-h-hamilton
+ */
+int fl_sampler_draw(fl_sampler s, void ** out, int k)
+{
+	if (s == NULL || out == NULL || k <= 0)
+		return 0;
+	if (k > s->len)
+		k = s->len;
+	for (int i = 0; i < k; i++) {
+		int j = i + (int) fl_sampler_below_(s, s->len - i);
+		void *a = s->slot[i];
+		void *b = s->slot[j];
+		s->slot[i] = b;
+		s->slot[j] = a;
+		s->pos[fl_sampler_find_(s, a)] = j;
+		s->pos[fl_sampler_find_(s, b)] = i;
+		out[i] = b;
+	}
+	return k;
+}
@@ -0,0 +1,63 @@
+#include <stddef.h>
+
+
+/**
+ * fl_sampler keeps a uniform random sample of at most `cap` items of a
+ * population that changes by insertions and removals, in O(1) per change.
+ *
+ * insertions go through reservoir sampling, and removals through random
+ * pairing (Gemulla, Lehner, Haas, "A dip in the reservoir", VLDB 2006): a
+ * removed item that was sampled leaves the sample, and the next insertions
+ * enter it with the probability that keeps it uniform until as many items
+ * have been inserted as were removed. in between, the sample can hold fewer
+ * than `cap` items; it is a uniform sample of its size at all times.
+ *
+ * items are opaque pointers (flist uses its nodes), identified by address.
+ *
+ * @nolan-h-hamilton
+ */
+
+
+#ifndef FLIST_SAMPLE_H_
+#define FLIST_SAMPLE_H_
+
+/* Structs */
+
+typedef struct {
+	/* sampled items, slot[0..len) */
+	void **slot;
+	int len;
+	int cap;
+	/* open-addressing index (linear probing) from an item to its slot, mask + 1 entries */
+	void **key;
+	int *pos;
+	size_t mask;
+	/* removals of sampled and of unsampled items not yet paired with an insertion */
+	long in;
+	long out;
+	unsigned long long rng;
+} fl_sampler_type, *fl_sampler;
+
+/***************/
+
+/* Functions */
+
+/* allocate an empty sampler holding at most `cap` items, with random seed `seed` */
+fl_sampler fl_sampler_make(int cap, unsigned long long seed);
+
+void fl_sampler_destroy(fl_sampler s);
+
+/* count `item`, which has just joined the population of now `n` items. O(1) */
+void fl_sampler_insert(fl_sampler s, void * item, long n);
+
+/* count `item`, which has just left the population. O(1) */
+void fl_sampler_remove(fl_sampler s, void * item);
+
+/* `item` is now known as `to`, e.g. after its node moved. O(1) */
+void fl_sampler_move(fl_sampler s, void * item, void * to);
+
+/* store min(k, s->len) distinct sampled items, chosen uniformly, in `out`; returns how many. O(k) */
+int fl_sampler_draw(fl_sampler s, void ** out, int k);
+/*********************/
+
+#endif
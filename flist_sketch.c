@@ -0,0 +1,412 @@
+/**
+ * DDSketch quantile sketch used by flist (see flist_sketch.h).
+ *
+ * positive values x are counted in bucket ceil(log_gamma(x)), negative values
+ * in the same bucket of a separate store keyed on |x|, and values closer to
+ * zero than `FL_SKETCH_MIN_VALUE` in `zero_count`.
+ *
+ * @nolan-h-hamilton
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include "flist_sketch.h"
+
+#define FL_SKETCH_MIN_VALUE 1e-9
+#define FL_SKETCH_MAGIC 0x4b53464c /* "FLSK" */
+#define FL_SKETCH_VERSION 1
+/* returned by fl_sketch_store_reserve_() when allocation fails */
+#define FL_SKETCH_NOMEM_ INT_MIN
+
+
+/**
+ * allocate memory for and initialize a new, empty sketch
+ *
+ * @nolan-h-hamilton
+ */
+fl_sketch fl_sketch_make(double alpha, int max_bins)
+{
+	if (!(alpha > 0 && alpha < 1) || max_bins < 1) {
+		printf("\nfl_sketch_make(): need 0 < alpha < 1 and max_bins >= 1...returning NULL\n");
+		return NULL;
+	}
+
+	fl_sketch sk = (fl_sketch) calloc(1, sizeof(fl_sketch_type));
+	if (sk == NULL) {
+		printf("\nmemory allocation for sketch failed...returning NULL\n");
+		return NULL;
+	}
+	sk->alpha = alpha;
+	sk->gamma = (1 + alpha) / (1 - alpha);
+	sk->log_gamma = log(sk->gamma);
+	sk->max_bins = max_bins;
+	return sk;
+}
+
+
+void fl_sketch_destroy(fl_sketch sk)
+{
+	if (sk == NULL)
+		return;
+	free(sk->pos.bins);
+	free(sk->neg.bins);
+	free(sk);
+}
+
+
+static int fl_sketch_store_copy_(fl_sketch_store * dst, const fl_sketch_store * src)
+{
+	*dst = *src;
+	if (src->nbins == 0)
+		return 1;
+	dst->bins = (double *) malloc(sizeof(double) * src->nbins);
+	if (dst->bins == NULL)
+		return 0;
+	memcpy(dst->bins, src->bins, sizeof(double) * src->nbins);
+	return 1;
+}
+
+
+/**
+ * deep copy of `sk`
+ *
+ * @nolan-h-hamilton
+ */
+fl_sketch fl_sketch_copy(fl_sketch sk)
+{
+	if (sk == NULL)
+		return NULL;
+
+	fl_sketch cpy = (fl_sketch) malloc(sizeof(fl_sketch_type));
+	if (cpy == NULL) {
+		printf("\nfl_sketch_copy(): memory allocation for sketch failed...returning NULL\n");
+		return NULL;
+	}
+	*cpy = *sk;
+	cpy->pos.bins = NULL;
+	cpy->neg.bins = NULL;
+	if (!fl_sketch_store_copy_(&cpy->pos, &sk->pos)
+	    || !fl_sketch_store_copy_(&cpy->neg, &sk->neg)) {
+		printf("\nfl_sketch_copy(): memory allocation for bins failed...returning NULL\n");
+		fl_sketch_destroy(cpy);
+		return NULL;
+	}
+	return cpy;
+}
+
+
+/**
+ * widen `st` so that it covers bucket `idx`, keeping at most `max_bins`
+ * buckets by folding the lowest ones into the lowest kept bucket, or the
+ * highest ones into the highest kept bucket if `high` is nonzero. the lowest
+ * buckets of the positive store and the highest of the negative one hold the
+ * values of lowest rank. returns the (possibly clamped) index to count into,
+ * or FL_SKETCH_NOMEM_ on allocation failure.
+ */
+static int fl_sketch_store_reserve_(fl_sketch_store * st, int idx, int max_bins, int high)
+{
+	if (st->nbins == 0) {
+		st->bins = (double *) calloc(1, sizeof(double));
+		if (st->bins == NULL)
+			return FL_SKETCH_NOMEM_;
+		st->offset = idx;
+		st->nbins = 1;
+		return idx;
+	}
+
+	int lo = st->offset;
+	int hi = st->offset + st->nbins - 1;
+	if (idx >= lo && idx <= hi)
+		return idx;
+
+	if (idx > hi)
+		hi = idx;
+	else
+		lo = idx;
+	if (hi - lo + 1 > max_bins) {
+		if (high)
+			hi = lo + max_bins - 1;
+		else
+			lo = hi - max_bins + 1;
+	}
+	if (idx < lo)
+		idx = lo;
+	if (idx > hi)
+		idx = hi;
+	if (lo == st->offset && hi == st->offset + st->nbins - 1)
+		return idx;
+
+	double *bins = (double *) calloc(hi - lo + 1, sizeof(double));
+	if (bins == NULL)
+		return FL_SKETCH_NOMEM_;
+	for (int i = 0; i < st->nbins; i++) {
+		int j = st->offset + i;
+		if (j < lo)
+			j = lo;
+		if (j > hi)
+			j = hi;
+		bins[j - lo] += st->bins[i];
+	}
+	free(st->bins);
+	st->bins = bins;
+	st->offset = lo;
+	st->nbins = hi - lo + 1;
+	return idx;
+}
+
+
+static int fl_sketch_index_(fl_sketch sk, double x)
+{
+	return (int) ceil(log(x) / sk->log_gamma);
+}
+
+
+/* representative value of bucket `idx`: the point of equal relative error */
+static double fl_sketch_value_(fl_sketch sk, int idx)
+{
+	return 2 * pow(sk->gamma, idx) / (sk->gamma + 1);
+}
+
+
+/**
+ * add `weight` occurrences of `x` in O(1), amortized over bucket range growth.
+ * a negative weight removes occurrences, which lets the sketch track deletions.
+ *
+ * @nolan-h-hamilton
+ */
+fl_sketch fl_sketch_add(fl_sketch sk, double x, double weight)
+{
+	if (sk == NULL) {
+		printf("\nfl_sketch_add(): sketch is NULL...returning NULL\n");
+		return NULL;
+	}
+	if (isnan(x))
+		return sk;
+
+	sk->count += weight;
+	if (fabs(x) < FL_SKETCH_MIN_VALUE) {
+		sk->zero_count += weight;
+		return sk;
+	}
+
+	fl_sketch_store *st = x > 0 ? &sk->pos : &sk->neg;
+	int idx = fl_sketch_store_reserve_(st, fl_sketch_index_(sk, fabs(x)), sk->max_bins, st == &sk->neg);
+	if (idx == FL_SKETCH_NOMEM_) {
+		printf("\nfl_sketch_add(): memory allocation for bins failed\n");
+		sk->count -= weight;
+		return sk;
+	}
+	st->bins[idx - st->offset] += weight;
+	return sk;
+}
+
+
+/**
+ * estimate the `q`-quantile in O(sketch size). the result is within relative
+ * error `alpha` of the value of that rank unless its bucket was collapsed.
+ * returns NAN for an empty sketch.
+ *
+ * @nolan-h-hamilton
+ */
+double fl_sketch_quantile(fl_sketch sk, double q)
+{
+	if (sk == NULL || sk->count <= 0 || q < 0 || q > 1)
+		return NAN;
+
+	double rank = q * (sk->count - 1);
+	double seen = 0;
+	int i;
+
+	/* most negative values live in the highest negative buckets */
+	for (i = sk->neg.nbins - 1; i >= 0; i--) {
+		seen += sk->neg.bins[i];
+		if (seen > rank)
+			return -fl_sketch_value_(sk, sk->neg.offset + i);
+	}
+	seen += sk->zero_count;
+	if (seen > rank)
+		return 0;
+	for (i = 0; i < sk->pos.nbins; i++) {
+		seen += sk->pos.bins[i];
+		if (seen > rank)
+			return fl_sketch_value_(sk, sk->pos.offset + i);
+	}
+
+	/* rounding: rank equals the total count */
+	if (sk->pos.nbins > 0)
+		return fl_sketch_value_(sk, sk->pos.offset + sk->pos.nbins - 1);
+	if (sk->zero_count > 0 || sk->neg.nbins == 0)
+		return 0;
+	return -fl_sketch_value_(sk, sk->neg.offset);
+}
+
+
+static int fl_sketch_store_merge_(fl_sketch_store * dst, const fl_sketch_store * src, int max_bins, int high)
+{
+	if (src->nbins == 0)
+		return 1;
+
+	/* reserve both ends first so the folding happens once */
+	if (fl_sketch_store_reserve_(dst, src->offset + src->nbins - 1, max_bins, high) == FL_SKETCH_NOMEM_
+	    || fl_sketch_store_reserve_(dst, src->offset, max_bins, high) == FL_SKETCH_NOMEM_)
+		return 0;
+	for (int i = 0; i < src->nbins; i++) {
+		int j = src->offset + i;
+		if (j < dst->offset)
+			j = dst->offset;
+		if (j > dst->offset + dst->nbins - 1)
+			j = dst->offset + dst->nbins - 1;
+		dst->bins[j - dst->offset] += src->bins[i];
+	}
+	return 1;
+}
+
+
+/**
+ * add the counts of `src` into `dst` in O(sketch size), without access to
+ * the values that were counted. both sketches must use the same `alpha`.
+ *
+ * @nolan-h-hamilton
+ */
+int fl_sketch_merge(fl_sketch dst, fl_sketch src)
+{
+	if (dst == NULL || src == NULL) {
+		printf("\nfl_sketch_merge(): sketch is NULL\n");
+		return 0;
+	}
+	if (dst->alpha != src->alpha) {
+		printf("\nfl_sketch_merge(): sketches have different accuracy\n");
+		return 0;
+	}
+
+	if (!fl_sketch_store_merge_(&dst->pos, &src->pos, dst->max_bins, 0)
+	    || !fl_sketch_store_merge_(&dst->neg, &src->neg, dst->max_bins, 1)) {
+		printf("\nfl_sketch_merge(): memory allocation for bins failed\n");
+		return 0;
+	}
+	dst->zero_count += src->zero_count;
+	dst->count += src->count;
+	return 1;
+}
+
+
+/*
+ * serialized layout, native byte order:
+ *   int32 magic, int32 version, double alpha, int32 max_bins,
+ *   double zero_count, double count,
+ *   int32 pos.offset, int32 pos.nbins, double[pos.nbins],
+ *   int32 neg.offset, int32 neg.nbins, double[neg.nbins]
+ */
+
+#define FL_SKETCH_PUT_(p, v) do { memcpy((p), &(v), sizeof(v)); (p) += sizeof(v); } while (0)
+#define FL_SKETCH_GET_(p, v) do { memcpy(&(v), (p), sizeof(v)); (p) += sizeof(v); } while (0)
+
+
+/**
+ * serialize `sk` into a malloc'd buffer and store its size in `nbytes`
+ *
+ * @nolan-h-hamilton
+ */
+void * fl_sketch_serialize(fl_sketch sk, size_t * nbytes)
+{
+	if (sk == NULL || nbytes == NULL) {
+		printf("\nfl_sketch_serialize(): sketch is NULL...returning NULL\n");
+		return NULL;
+	}
+
+	int magic = FL_SKETCH_MAGIC;
+	int version = FL_SKETCH_VERSION;
+	size_t size = 7 * sizeof(int) + 3 * sizeof(double)
+		+ sizeof(double) * (sk->pos.nbins + sk->neg.nbins);
+	unsigned char *buf = (unsigned char *) malloc(size);
+	if (buf == NULL) {
+		printf("\nfl_sketch_serialize(): memory allocation failed...returning NULL\n");
+		return NULL;
+	}
+
+	unsigned char *p = buf;
+	FL_SKETCH_PUT_(p, magic);
+	FL_SKETCH_PUT_(p, version);
+	FL_SKETCH_PUT_(p, sk->alpha);
+	FL_SKETCH_PUT_(p, sk->max_bins);
+	FL_SKETCH_PUT_(p, sk->zero_count);
+	FL_SKETCH_PUT_(p, sk->count);
+	FL_SKETCH_PUT_(p, sk->pos.offset);
+	FL_SKETCH_PUT_(p, sk->pos.nbins);
+	memcpy(p, sk->pos.bins, sizeof(double) * sk->pos.nbins);
+	p += sizeof(double) * sk->pos.nbins;
+	FL_SKETCH_PUT_(p, sk->neg.offset);
+	FL_SKETCH_PUT_(p, sk->neg.nbins);
+	memcpy(p, sk->neg.bins, sizeof(double) * sk->neg.nbins);
+
+	*nbytes = size;
+	return buf;
+}
+
+
+static const unsigned char * fl_sketch_get_store_(const unsigned char * p, const unsigned char * end,
+						  fl_sketch_store * st, int max_bins)
+{
+	if (p == NULL || end - p < (long) (2 * sizeof(int)))
+		return NULL;
+	FL_SKETCH_GET_(p, st->offset);
+	FL_SKETCH_GET_(p, st->nbins);
+	if (st->nbins < 0 || st->nbins > max_bins
+	    || end - p < (long) (sizeof(double) * st->nbins))
+		return NULL;
+	if (st->nbins == 0)
+		return p;
+	st->bins = (double *) malloc(sizeof(double) * st->nbins);
+	if (st->bins == NULL)
+		return NULL;
+	memcpy(st->bins, p, sizeof(double) * st->nbins);
+	return p + sizeof(double) * st->nbins;
+}
+
+
+/**
+ * rebuild a sketch from the output of fl_sketch_serialize()
+ *
+ * @nolan-h-hamilton
+ */
+fl_sketch fl_sketch_deserialize(const void * buf, size_t nbytes)
+{
+	const unsigned char *p = (const unsigned char *) buf;
+	const unsigned char *end = p + nbytes;
+	int magic, version, max_bins;
+	double alpha;
+
+	if (buf == NULL || nbytes < 3 * sizeof(int) + sizeof(double)) {
+		printf("\nfl_sketch_deserialize(): buffer too small...returning NULL\n");
+		return NULL;
+	}
+	FL_SKETCH_GET_(p, magic);
+	FL_SKETCH_GET_(p, version);
+	FL_SKETCH_GET_(p, alpha);
+	FL_SKETCH_GET_(p, max_bins);
+	if (magic != FL_SKETCH_MAGIC || version != FL_SKETCH_VERSION) {
+		printf("\nfl_sketch_deserialize(): not a serialized sketch...returning NULL\n");
+		return NULL;
+	}
+
+	fl_sketch sk = fl_sketch_make(alpha, max_bins);
+	if (sk == NULL)
+		return NULL;
+	if (end - p < (long) (2 * sizeof(double))) {
+		fl_sketch_destroy(sk);
+		return NULL;
+	}
+	FL_SKETCH_GET_(p, sk->zero_count);
+	FL_SKETCH_GET_(p, sk->count);
+	p = fl_sketch_get_store_(p, end, &sk->pos, max_bins);
+	p = fl_sketch_get_store_(p, end, &sk->neg, max_bins);
+	if (p == NULL) {
+		printf("\nfl_sketch_deserialize(): truncated or corrupt buffer...returning NULL\n");
+		fl_sketch_destroy(sk);
+		return NULL;
+	}
+	return sk;
+}
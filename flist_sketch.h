@@ -0,0 +1,70 @@
+#include <stddef.h>
+
+
+/**
+ * fl_sketch is a mergeable quantile sketch (DDSketch) with bounded memory.
+ *
+ * values are counted in logarithmically spaced buckets so that every quantile
+ * estimate is within a relative error `alpha` of a value in the data, for as
+ * long as the number of buckets stays below `max_bins` per sign; beyond that
+ * the buckets of the values nearest zero among the positive ones, and of the
+ * values farthest from zero among the negative ones, are collapsed together,
+ * which only affects the accuracy of the lowest quantiles. bucket counts can be decremented, so the sketch can
+ * follow removals from an flist as well as insertions, and two sketches with
+ * the same `alpha` merge exactly by adding bucket counts.
+ *
+ * @nolan-h-hamilton
+ */
+
+
+#ifndef FLIST_SKETCH_H_
+#define FLIST_SKETCH_H_
+
+/* Structs */
+
+/* dense run of bucket counts for indexes [offset, offset + nbins) */
+typedef struct {
+	double *bins;
+	int offset;
+	int nbins;
+} fl_sketch_store;
+
+typedef struct {
+	double alpha;
+	double gamma;
+	double log_gamma;
+	int max_bins;
+	fl_sketch_store pos;
+	fl_sketch_store neg;
+	double zero_count;
+	double count;
+} fl_sketch_type, *fl_sketch;
+
+/***************/
+
+/* Functions */
+
+/* allocate a sketch with relative accuracy `alpha` using at most `max_bins` buckets per sign */
+fl_sketch fl_sketch_make(double alpha, int max_bins);
+
+void fl_sketch_destroy(fl_sketch sk);
+
+fl_sketch fl_sketch_copy(fl_sketch sk);
+
+/* add `weight` occurrences of `x` (negative weight removes) in O(1) amortized */
+fl_sketch fl_sketch_add(fl_sketch sk, double x, double weight);
+
+/* estimate the `q`-quantile, 0 <= q <= 1, in O(sketch size) */
+double fl_sketch_quantile(fl_sketch sk, double q);
+
+/* add the counts of `src` to `dst` in O(sketch size). returns 0 if `alpha` differs */
+int fl_sketch_merge(fl_sketch dst, fl_sketch src);
+
+/* serialize to a malloc'd buffer of `*nbytes` bytes (native byte order) */
+void * fl_sketch_serialize(fl_sketch sk, size_t * nbytes);
+
+/* rebuild a sketch from fl_sketch_serialize() output, or NULL if malformed */
+fl_sketch fl_sketch_deserialize(const void * buf, size_t nbytes);
+/*********************/
+
+#endif
@@ -0,0 +1,626 @@
+/**
+ * float32 and int64 flist variants (see flist_typed.h).
+ *
+ * the list structure is identical for both types, so the node/ring
+ * manipulation is generated by FL_TYPED_DEFINE() below; only
+ * *_update_measures(), *_add_bulk_() and the bulk kernels are written per type.
+ *
+ * @nolan-h-hamilton
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "flist_typed.h"
+
+/* float32 counterpart of FL_EPSILON */
+#define FL_F32_EPSILON 1e-6f
+
+
+/**
+ * generate the structural functions of a typed flist. `pfx` is the function
+ * prefix, `T` the element type, `LIST` the list pointer type and `NEAR` the
+ * equality test used by find.
+ * `pfx##_update_measures()` and `pfx##_add_bulk_()` must be declared before
+ * expansion.
+ */
+#define FL_TYPED_DEFINE(pfx, T, LIST, NEAR)					\
+										\
+pfx##_node pfx##_make_node(T n)							\
+{										\
+	pfx##_node nd = (pfx##_node) malloc(sizeof(pfx##_node_type));		\
+	if (nd == NULL) {							\
+		printf("\n" #pfx "_make_node(): memory allocation for node failed...returning NULL\n"); \
+		return NULL;							\
+	}									\
+	nd->num = n;								\
+	nd->next = NULL;							\
+	nd->prev = NULL;							\
+	return nd;								\
+}										\
+										\
+LIST pfx##_append(LIST l, T n)							\
+{										\
+	if (l == NULL) {							\
+		printf("\n" #pfx "_append(): flist `l` does not exist...returning NULL\n"); \
+		return NULL;							\
+	}									\
+	pfx##_node nd = pfx##_make_node(n);					\
+	if (nd == NULL)								\
+		return NULL;							\
+	if (l->len == 0) {							\
+		l->head = nd;							\
+		l->tail = nd;							\
+		nd->next = nd;							\
+		nd->prev = nd;							\
+		return pfx##_update_measures(l, n, 1);				\
+	}									\
+	nd->prev = l->tail;							\
+	nd->next = l->head;							\
+	l->tail->next = nd;							\
+	l->tail = nd;								\
+	l->head->prev = nd;							\
+	return pfx##_update_measures(l, n, 1);					\
+}										\
+										\
+LIST pfx##_push(LIST l, T n)							\
+{										\
+	if (l == NULL) {							\
+		printf("\n" #pfx "_push(): flist `l` does not exist...returning NULL\n"); \
+		return NULL;							\
+	}									\
+	if (pfx##_append(l, n) == NULL)						\
+		return NULL;							\
+	/* the new tail becomes head by rotating the ring one step back */	\
+	l->head = l->tail;							\
+	l->tail = l->tail->prev;						\
+	return l;								\
+}										\
+										\
+/* unlink `nd` from `l`, free it and return its value */			\
+static T pfx##_unlink_(LIST l, pfx##_node nd)					\
+{										\
+	T ret = nd->num;							\
+	if (l->len == 1) {							\
+		l->head = NULL;							\
+		l->tail = NULL;							\
+	} else {								\
+		nd->prev->next = nd->next;					\
+		nd->next->prev = nd->prev;					\
+		if (nd == l->head)						\
+			l->head = nd->next;					\
+		if (nd == l->tail)						\
+			l->tail = nd->prev;					\
+	}									\
+	pfx##_update_measures(l, ret, 0);					\
+	free(nd);								\
+	return ret;								\
+}										\
+										\
+T pfx##_pop(LIST l)								\
+{										\
+	if (l == NULL || l->len == 0) {						\
+		printf("\n" #pfx "_pop(): cannot pop empty flist\n");		\
+		exit(1);							\
+	}									\
+	return pfx##_unlink_(l, l->head);					\
+}										\
+										\
+T pfx##_dequeue(LIST l)								\
+{										\
+	if (l == NULL || l->len == 0) {						\
+		printf("\n" #pfx "_dequeue(): cannot dequeue empty flist\n");	\
+		exit(1);							\
+	}									\
+	return pfx##_unlink_(l, l->tail);					\
+}										\
+										\
+pfx##_node pfx##_get_kth(LIST l, int k)						\
+{										\
+	if (l == NULL || l->len == 0 || k < 0 || k >= l->len)			\
+		return NULL;							\
+	pfx##_node nd;								\
+	int i;									\
+	/* if index k is past midpoint, traverse list from back */		\
+	if (k > l->len / 2) {							\
+		nd = l->tail;							\
+		for (i = l->len - 1; i > k; i--)				\
+			nd = nd->prev;						\
+	} else {								\
+		nd = l->head;							\
+		for (i = 0; i < k; i++)						\
+			nd = nd->next;						\
+	}									\
+	return nd;								\
+}										\
+										\
+pfx##_node pfx##_find(LIST l, T n)						\
+{										\
+	if (l == NULL || l->len == 0)						\
+		return NULL;							\
+	pfx##_node nd = l->head;						\
+	int i;									\
+	for (i = 0; i < l->len; i++) {						\
+		if (NEAR(nd->num, n))						\
+			return nd;						\
+		nd = nd->next;							\
+	}									\
+	return NULL;								\
+}										\
+										\
+LIST pfx##_remove_index(LIST l, int index)					\
+{										\
+	if (l == NULL) {							\
+		printf("\n" #pfx "_remove_index(): flist `l` is NULL...returning NULL\n"); \
+		return NULL;							\
+	}									\
+	pfx##_node nd = pfx##_get_kth(l, index);				\
+	if (nd == NULL) {							\
+		printf("\n" #pfx "_remove_index(): index does not exist\n");	\
+		return NULL;							\
+	}									\
+	pfx##_unlink_(l, nd);							\
+	return l;								\
+}										\
+										\
+void pfx##_destroy(LIST l)							\
+{										\
+	if (l == NULL) {							\
+		printf("\n" #pfx "_destroy(): flist `l` does not exist...\n");	\
+		return;								\
+	}									\
+	pfx##_node nd = l->head;						\
+	int i;									\
+	for (i = 0; i < l->len; i++) {						\
+		pfx##_node cpy = nd->next;					\
+		free(nd);							\
+		nd = cpy;							\
+	}									\
+	l->head = NULL;								\
+	l->tail = NULL;								\
+	l->len = 0;								\
+}										\
+										\
+T * pfx##_to_arr(LIST l)							\
+{										\
+	if (l == NULL || l->len == 0)						\
+		return NULL;							\
+	T * arr = (T *) malloc(sizeof(T) * l->len);				\
+	if (arr == NULL) {							\
+		printf("\n" #pfx "_to_arr(): memory allocation for array failed\n"); \
+		return NULL;							\
+	}									\
+	pfx##_node nd = l->head;						\
+	int i;									\
+	for (i = 0; i < l->len; i++) {						\
+		arr[i] = nd->num;						\
+		nd = nd->next;							\
+	}									\
+	return arr;								\
+}										\
+										\
+void pfx##_from_arr(LIST l, const T * arr, int arr_len)				\
+{										\
+	if (l == NULL) {							\
+		printf("\n" #pfx "_from_arr(): flist is null...return\n");	\
+		return;								\
+	}									\
+	if (arr == NULL) {							\
+		printf("\n" #pfx "_from_arr(): array is null...return\n");	\
+		return;								\
+	}									\
+	int i;									\
+	for (i = 0; i < arr_len; i++) {						\
+		pfx##_node nd = pfx##_make_node(arr[i]);			\
+		if (nd == NULL)							\
+			break;							\
+		if (l->len + i == 0) {						\
+			l->head = nd;						\
+			nd->prev = nd;						\
+		} else {							\
+			nd->prev = l->tail;					\
+			l->tail->next = nd;					\
+		}								\
+		l->tail = nd;							\
+	}									\
+	if (i > 0) {								\
+		l->tail->next = l->head;					\
+		l->head->prev = l->tail;					\
+		pfx##_add_bulk_(l, arr, i);					\
+	}									\
+}
+
+/**
+ * float32 version of fl_near(), using `FL_F32_EPSILON`
+ *
+ * @nolan-h-hamilton
+ */
+int fl_f32_near(float a, float b)
+{
+	float diff = fabsf(a - b);
+	float d = fmaxf(fabsf(a), fabsf(b));
+	float rel_cmp = d * FL_F32_EPSILON;
+
+	if (FL_F32_EPSILON > rel_cmp)
+		return diff <= FL_F32_EPSILON;
+	return diff <= rel_cmp;
+}
+
+
+/**
+ * allocate memory for and initialize new float32 flist
+ *
+ * @nolan-h-hamilton
+ */
+flist_f32 fl_f32_make_flist()
+{
+	flist_f32 l = (flist_f32) calloc(1, sizeof(flist_f32_type));
+
+	if (l == NULL) {
+		printf("\nmemory allocation for flist failed..returning NULL\n");
+		return NULL;
+	}
+	return l;
+}
+
+
+/*
+ * recompute variance/std_dev from len and the running m2, which does not
+ * cancel the way sumsq / len - mean^2 does when the mean is large
+ */
+static void fl_f32_moments_(flist_f32 l)
+{
+	if (l->len == 0) {
+		l->sum = 0;
+		l->sumsq = 0;
+		l->mean = 0;
+		l->m2 = 0;
+		l->variance = 0;
+		l->std_dev = 0;
+		return;
+	}
+	if (l->m2 < 0)
+		l->m2 = 0;
+	l->variance = l->m2 / l->len;
+	l->std_dev = sqrt(l->variance);
+}
+
+
+/**
+ * float32 version of fl_update_measures(); accumulation is in double
+ *
+ * @nolan-h-hamilton
+ */
+flist_f32 fl_f32_update_measures(flist_f32 l, float n, int add)
+{
+	if (l == NULL) {
+		printf("\nfl_f32_update_measures(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+
+	double d = n;
+	double dev = d - l->mean;
+	if (add) {
+		l->len++;
+		l->sum += d;
+		l->sumsq += d * d;
+		l->mean += dev / l->len;
+		l->m2 += dev * (d - l->mean);
+	} else {
+		l->len--;
+		l->sum -= d;
+		l->sumsq -= d * d;
+		if (l->len > 0) {
+			l->mean -= dev / l->len;
+			l->m2 -= dev * (d - l->mean);
+		}
+	}
+	fl_f32_moments_(l);
+	return l;
+}
+
+
+/* merge the moments of `arr` into those of `l` (Chan et al.), the array's m2 taken about its own mean */
+static void fl_f32_add_bulk_(flist_f32 l, const float * arr, int n)
+{
+	if (n <= 0)
+		return;
+	double sum = fl_f32_arr_sum(arr, n);
+	double mean = sum / n;
+	double m2 = 0;
+	for (int i = 0; i < n; i++)
+		m2 += (arr[i] - mean) * (arr[i] - mean);
+	double d = mean - l->mean;
+	double na = l->len;
+	l->len += n;
+	l->sum += sum;
+	l->sumsq += fl_f32_arr_sumsq(arr, n);
+	l->mean += d * n / l->len;
+	l->m2 += m2 + d * d * na * n / l->len;
+	fl_f32_moments_(l);
+}
+
+
+FL_TYPED_DEFINE(fl_f32, float, flist_f32, fl_f32_near)
+
+
+/**
+ * allocate memory for and initialize new int64 flist
+ *
+ * @nolan-h-hamilton
+ */
+flist_i64 fl_i64_make_flist()
+{
+	flist_i64 l = (flist_i64) calloc(1, sizeof(flist_i64_type));
+
+	if (l == NULL) {
+		printf("\nmemory allocation for flist failed..returning NULL\n");
+		return NULL;
+	}
+	return l;
+}
+
+
+/**
+ * recompute mean/variance/std_dev from the exact len, sum and sumsq.
+ * variance is formed as (sumsq - sum^2 / len) / len so that the
+ * cancellation happens before conversion to double.
+ */
+static void fl_i64_moments_(flist_i64 l)
+{
+	if (l->len == 0) {
+		l->sum = 0;
+		l->sumsq = 0;
+		l->mean = 0;
+		l->variance = 0;
+		l->std_dev = 0;
+		return;
+	}
+	long double sum = (long double) l->sum;
+	l->mean = (double) (sum / l->len);
+	l->variance = (double) (((long double) l->sumsq - sum * sum / l->len) / l->len);
+	l->std_dev = sqrt(l->variance);
+}
+
+
+/**
+ * int64 version of fl_update_measures(); sum and sumsq are exact within the
+ * ranges noted at flist_i64_type
+ *
+ * @nolan-h-hamilton
+ */
+flist_i64 fl_i64_update_measures(flist_i64 l, int64_t n, int add)
+{
+	if (l == NULL) {
+		printf("\nfl_i64_update_measures(): flist `l` is NULL, returning NULL\n");
+		return NULL;
+	}
+
+	fl_i64_wide sq = (fl_i64_wide) n * n;
+	if (add) {
+		l->len++;
+		l->sum = (int64_t) ((uint64_t) l->sum + (uint64_t) n);
+		l->sumsq += sq;
+	} else {
+		l->len--;
+		l->sum = (int64_t) ((uint64_t) l->sum - (uint64_t) n);
+		l->sumsq -= sq;
+	}
+	fl_i64_moments_(l);
+	return l;
+}
+
+
+static void fl_i64_add_bulk_(flist_i64 l, const int64_t * arr, int n)
+{
+	l->len += n;
+	l->sum = (int64_t) ((uint64_t) l->sum + (uint64_t) fl_i64_arr_sum(arr, n));
+	l->sumsq += fl_i64_arr_sumsq(arr, n);
+	fl_i64_moments_(l);
+}
+
+
+static int fl_i64_eq_(int64_t a, int64_t b)
+{
+	return a == b;
+}
+
+
+FL_TYPED_DEFINE(fl_i64, int64_t, flist_i64, fl_i64_eq_)
+
+
+/**
+ * bulk kernels. each AVX2 path handles the largest multiple of the vector
+ * width and leaves the remainder to the scalar loop that is also the
+ * fallback on other targets.
+ */
+
+double fl_f32_arr_sum(const float * arr, int n)
+{
+	double sum = 0;
+	int i = 0;
+#ifdef __AVX2__
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	for (; i + 8 <= n; i += 8) {
+		__m256 v = _mm256_loadu_ps(arr + i);
+		acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+		acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+	sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+	for (; i < n; i++)
+		sum += arr[i];
+	return sum;
+}
+
+
+double fl_f32_arr_sumsq(const float * arr, int n)
+{
+	double sumsq = 0;
+	int i = 0;
+#ifdef __AVX2__
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	for (; i + 8 <= n; i += 8) {
+		__m256 v = _mm256_loadu_ps(arr + i);
+		__m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+		__m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+		acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(lo, lo));
+		acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(hi, hi));
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+	sumsq = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+	for (; i < n; i++)
+		sumsq += (double) arr[i] * arr[i];
+	return sumsq;
+}
+
+
+void fl_f32_arr_min_max(const float * arr, int n, float * min, float * max)
+{
+	if (arr == NULL || n <= 0)
+		return;
+	float lo = arr[0];
+	float hi = arr[0];
+	int i = 0;
+#ifdef __AVX2__
+	if (n >= 8) {
+		__m256 vlo = _mm256_loadu_ps(arr);
+		__m256 vhi = vlo;
+		for (i = 8; i + 8 <= n; i += 8) {
+			__m256 v = _mm256_loadu_ps(arr + i);
+			vlo = _mm256_min_ps(vlo, v);
+			vhi = _mm256_max_ps(vhi, v);
+		}
+		float l8[8], h8[8];
+		_mm256_storeu_ps(l8, vlo);
+		_mm256_storeu_ps(h8, vhi);
+		for (int j = 0; j < 8; j++) {
+			if (l8[j] < lo) lo = l8[j];
+			if (h8[j] > hi) hi = h8[j];
+		}
+	}
+#endif
+	for (; i < n; i++) {
+		if (arr[i] < lo) lo = arr[i];
+		if (arr[i] > hi) hi = arr[i];
+	}
+	if (min != NULL) *min = lo;
+	if (max != NULL) *max = hi;
+}
+
+
+int fl_f32_arr_search(const float * arr, int n, float v)
+{
+	int i = 0;
+#ifdef __AVX2__
+	/* vectorized fl_f32_near(): |a - v| <= max(FL_F32_EPSILON, max(|a|, |v|) * FL_F32_EPSILON) */
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	const __m256 eps = _mm256_set1_ps(FL_F32_EPSILON);
+	const __m256 vv = _mm256_set1_ps(v);
+	const __m256 vabs = _mm256_andnot_ps(sign, vv);
+	for (; i + 8 <= n; i += 8) {
+		__m256 a = _mm256_loadu_ps(arr + i);
+		__m256 diff = _mm256_andnot_ps(sign, _mm256_sub_ps(a, vv));
+		__m256 d = _mm256_max_ps(_mm256_andnot_ps(sign, a), vabs);
+		__m256 tol = _mm256_max_ps(eps, _mm256_mul_ps(d, eps));
+		int mask = _mm256_movemask_ps(_mm256_cmp_ps(diff, tol, _CMP_LE_OQ));
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+	for (; i < n; i++)
+		if (fl_f32_near(arr[i], v))
+			return i;
+	return -1;
+}
+
+
+int64_t fl_i64_arr_sum(const int64_t * arr, int n)
+{
+	/* unsigned arithmetic wraps like the two's complement hardware add */
+	uint64_t sum = 0;
+	int i = 0;
+#ifdef __AVX2__
+	__m256i acc = _mm256_setzero_si256();
+	for (; i + 4 <= n; i += 4)
+		acc = _mm256_add_epi64(acc, _mm256_loadu_si256((const __m256i *) (arr + i)));
+	int64_t lanes[4];
+	_mm256_storeu_si256((__m256i *) lanes, acc);
+	sum = (uint64_t) lanes[0] + (uint64_t) lanes[1] + (uint64_t) lanes[2] + (uint64_t) lanes[3];
+#endif
+	for (; i < n; i++)
+		sum += (uint64_t) arr[i];
+	return (int64_t) sum;
+}
+
+
+/* 64x64 -> 128-bit products have no AVX2 instruction, so this one stays scalar */
+fl_i64_wide fl_i64_arr_sumsq(const int64_t * arr, int n)
+{
+	fl_i64_wide sumsq = 0;
+	for (int i = 0; i < n; i++)
+		sumsq += (fl_i64_wide) arr[i] * arr[i];
+	return sumsq;
+}
+
+
+void fl_i64_arr_min_max(const int64_t * arr, int n, int64_t * min, int64_t * max)
+{
+	if (arr == NULL || n <= 0)
+		return;
+	int64_t lo = arr[0];
+	int64_t hi = arr[0];
+	int i = 0;
+#ifdef __AVX2__
+	if (n >= 4) {
+		__m256i vlo = _mm256_loadu_si256((const __m256i *) arr);
+		__m256i vhi = vlo;
+		for (i = 4; i + 4 <= n; i += 4) {
+			__m256i v = _mm256_loadu_si256((const __m256i *) (arr + i));
+			vlo = _mm256_blendv_epi8(vlo, v, _mm256_cmpgt_epi64(vlo, v));
+			vhi = _mm256_blendv_epi8(vhi, v, _mm256_cmpgt_epi64(v, vhi));
+		}
+		int64_t l4[4], h4[4];
+		_mm256_storeu_si256((__m256i *) l4, vlo);
+		_mm256_storeu_si256((__m256i *) h4, vhi);
+		for (int j = 0; j < 4; j++) {
+			if (l4[j] < lo) lo = l4[j];
+			if (h4[j] > hi) hi = h4[j];
+		}
+	}
+#endif
+	for (; i < n; i++) {
+		if (arr[i] < lo) lo = arr[i];
+		if (arr[i] > hi) hi = arr[i];
+	}
+	if (min != NULL) *min = lo;
+	if (max != NULL) *max = hi;
+}
+
+
+int fl_i64_arr_search(const int64_t * arr, int n, int64_t v)
+{
+	int i = 0;
+#ifdef __AVX2__
+	const __m256i vv = _mm256_set1_epi64x(v);
+	for (; i + 4 <= n; i += 4) {
+		__m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) (arr + i)), vv);
+		int mask = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+	for (; i < n; i++)
+		if (arr[i] == v)
+			return i;
+	return -1;
+}
@@ -0,0 +1,174 @@
+#include <stdint.h>
+
+
+/**
+ * typed flist variants for float and int64_t elements.
+ *
+ * flist stores every value as a double, which loses exactness above 2^53 for
+ * int64 counters. flist_f32 and flist_i64 keep the same doubly-linked,
+ * circular layout and the same O(1) head/tail access and incrementally
+ * maintained measures, but store the native element type. flist_i64
+ * accumulates sum and sumsq in integer arithmetic, see flist_i64_type.
+ *
+ * the two link pointers dominate a node, so an fl_f32_node is padded to the
+ * same 24 bytes as an fl_node on 64-bit targets: the list itself saves no
+ * memory. the float saving is in the arrays the bulk kernels run over.
+ *
+ * the bulk kernels (fl_f32_arr_sum(), fl_i64_arr_min_max(), ...) operate on
+ * contiguous segments, e.g. the output of fl_f32_to_arr() or the input of
+ * fl_f32_from_arr(), and use AVX2 when the translation unit is compiled with
+ * it (-mavx2), falling back to portable scalar loops otherwise.
+ *
+ * @nolan-h-hamilton
+ */
+
+
+#ifndef FLIST_TYPED_H_
+#define FLIST_TYPED_H_
+
+/* Structs */
+
+typedef struct fl_f32_node {
+	float num;
+	struct fl_f32_node *prev;
+	struct fl_f32_node *next;
+} fl_f32_node_type, *fl_f32_node;
+
+typedef struct {
+	fl_f32_node head;
+	fl_f32_node tail;
+	double mean;
+	double variance;
+	double std_dev;
+	double sumsq;
+	double sum;
+	/* sum of squared deviations from the mean (Welford), behind variance */
+	double m2;
+	int len;
+} flist_f32_type, *flist_f32;
+
+
+/*
+ * accumulator for the sum of squares of int64 values. unsigned __int128
+ * wraps modulo 2^128 and is exact while the sum stays below it, e.g. for any
+ * number of values below 2^48 in magnitude. the long double fallback is
+ * exact only below 2^64 where it is the x87 80-bit type, and below 2^53
+ * where it is a plain double.
+ */
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 fl_i64_wide;
+#else
+typedef long double fl_i64_wide;
+#endif
+
+typedef struct fl_i64_node {
+	int64_t num;
+	struct fl_i64_node *prev;
+	struct fl_i64_node *next;
+} fl_i64_node_type, *fl_i64_node;
+
+typedef struct {
+	fl_i64_node head;
+	fl_i64_node tail;
+	double mean;
+	double variance;
+	double std_dev;
+	fl_i64_wide sumsq;
+	/* wraps modulo 2^64 like int64 addition, so it is exact while the sum fits an int64 */
+	int64_t sum;
+	int len;
+} flist_i64_type, *flist_i64;
+
+/***************/
+
+/* Functions */
+
+/* float32 flist. semantics match the corresponding fl_* function */
+
+int fl_f32_near(float a, float b);
+
+fl_f32_node fl_f32_make_node(float n);
+
+flist_f32 fl_f32_make_flist();
+
+flist_f32 fl_f32_update_measures(flist_f32 l, float n, int add);
+
+flist_f32 fl_f32_append(flist_f32 l, float n);
+
+flist_f32 fl_f32_push(flist_f32 l, float n);
+
+float fl_f32_pop(flist_f32 l);
+
+float fl_f32_dequeue(flist_f32 l);
+
+fl_f32_node fl_f32_get_kth(flist_f32 l, int k);
+
+fl_f32_node fl_f32_find(flist_f32 l, float n);
+
+flist_f32 fl_f32_remove_index(flist_f32 l, int index);
+
+/* free the nodes of `l`; like fl_destroy(), the flist itself is left to the caller */
+void fl_f32_destroy(flist_f32 l);
+
+float * fl_f32_to_arr(flist_f32 l);
+
+/* append `arr_len` floats, updating measures once with the bulk kernels */
+void fl_f32_from_arr(flist_f32 l, const float * arr, int arr_len);
+
+
+/* int64 flist. sum and sumsq are exact within the ranges of flist_i64_type */
+
+fl_i64_node fl_i64_make_node(int64_t n);
+
+flist_i64 fl_i64_make_flist();
+
+flist_i64 fl_i64_update_measures(flist_i64 l, int64_t n, int add);
+
+flist_i64 fl_i64_append(flist_i64 l, int64_t n);
+
+flist_i64 fl_i64_push(flist_i64 l, int64_t n);
+
+int64_t fl_i64_pop(flist_i64 l);
+
+int64_t fl_i64_dequeue(flist_i64 l);
+
+fl_i64_node fl_i64_get_kth(flist_i64 l, int k);
+
+fl_i64_node fl_i64_find(flist_i64 l, int64_t n);
+
+flist_i64 fl_i64_remove_index(flist_i64 l, int index);
+
+/* free the nodes of `l`; like fl_destroy(), the flist itself is left to the caller */
+void fl_i64_destroy(flist_i64 l);
+
+int64_t * fl_i64_to_arr(flist_i64 l);
+
+/* append `arr_len` int64s, updating measures once with the bulk kernels */
+void fl_i64_from_arr(flist_i64 l, const int64_t * arr, int arr_len);
+
+
+/* bulk kernels over contiguous segments */
+
+/* float values are accumulated in double */
+double fl_f32_arr_sum(const float * arr, int n);
+
+double fl_f32_arr_sumsq(const float * arr, int n);
+
+/* store min and max of `arr` in `min`/`max`. no-op if n <= 0 */
+void fl_f32_arr_min_max(const float * arr, int n, float * min, float * max);
+
+/* index of first element fl_f32_near() `v`, or -1 */
+int fl_f32_arr_search(const float * arr, int n, float v);
+
+/* exact modulo 2^64, like int64 addition */
+int64_t fl_i64_arr_sum(const int64_t * arr, int n);
+
+fl_i64_wide fl_i64_arr_sumsq(const int64_t * arr, int n);
+
+void fl_i64_arr_min_max(const int64_t * arr, int n, int64_t * min, int64_t * max);
+
+/* index of first element equal to `v`, or -1 */
+int fl_i64_arr_search(const int64_t * arr, int n, int64_t v);
+/*********************/
+
+#endif
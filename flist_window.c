@@ -0,0 +1,281 @@
+/**
+ * time-windowed flist (see flist_window.h).
+ *
+ * @nolan-h-hamilton
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "flist_window.h"
+
+
+/* make room for one more node in `dq`, doubling its buffer when full */
+static int fl_win_dq_reserve_(fl_win_deque * dq)
+{
+	if (dq->len == dq->cap) {
+		int cap = dq->cap > 0 ? 2 * dq->cap : 16;
+		fl_win_node *buf = (fl_win_node *) malloc(sizeof(fl_win_node) * cap);
+		if (buf == NULL) {
+			printf("\nfl_win_append(): memory allocation for deque failed\n");
+			return 0;
+		}
+		/* unwrap the old contents to the front of the new buffer */
+		for (int i = 0; i < dq->len; i++)
+			buf[i] = dq->buf[(dq->start + i) % dq->cap];
+		free(dq->buf);
+		dq->buf = buf;
+		dq->cap = cap;
+		dq->start = 0;
+	}
+	return 1;
+}
+
+
+/* append `nd` at the back of `dq`, which must have room */
+static void fl_win_dq_push_(fl_win_deque * dq, fl_win_node nd)
+{
+	dq->buf[(dq->start + dq->len) % dq->cap] = nd;
+	dq->len++;
+}
+
+
+static fl_win_node fl_win_dq_back_(fl_win_deque * dq)
+{
+	return dq->buf[(dq->start + dq->len - 1) % dq->cap];
+}
+
+
+/* drop the front of `dq` if it is `nd`, which is leaving the window */
+static void fl_win_dq_expire_(fl_win_deque * dq, fl_win_node nd)
+{
+	if (dq->len > 0 && dq->buf[dq->start] == nd) {
+		dq->start = (dq->start + 1) % dq->cap;
+		dq->len--;
+	}
+}
+
+
+/* recompute the measures derived from the moments and the deques */
+static void fl_win_measures_(flist_win l)
+{
+	if (l->len == 0) {
+		l->mom = fl_moments_of(0, 0);
+		l->mean = 0;
+		l->variance = 0;
+		l->std_dev = 0;
+		l->sum = 0;
+		l->sumsq = 0;
+		l->min = 0;
+		l->max = 0;
+		return;
+	}
+	l->sum = l->mom.sum;
+	l->sumsq = l->mom.sumsq;
+	l->mean = l->mom.mean;
+	/* m2 is clamped at 0 by fl_moments_merge(), so the variance never goes negative */
+	l->variance = l->mom.m2 / l->len;
+	l->std_dev = sqrt(l->variance);
+	l->min = l->mins.buf[l->mins.start]->num;
+	l->max = l->maxs.buf[l->maxs.start]->num;
+}
+
+
+/**
+ * pop up to `limit` values with timestamp < `t` from the head, then relink
+ * the ring and update the measures once. returns the count popped.
+ */
+static int fl_win_drop_(flist_win l, double t, int limit)
+{
+	int k = 0;
+	fl_moments_type gone = fl_moments_of(0, 0);
+	fl_win_node nd = l->head;
+	while (k < limit && k < l->len && nd->ts < t) {
+		fl_win_node nxt = nd->next;
+		fl_win_dq_expire_(&l->mins, nd);
+		fl_win_dq_expire_(&l->maxs, nd);
+		fl_moments_type x = fl_moments_of(nd->num, 1);
+		fl_moments_merge(&gone, &x, 1);
+		free(nd);
+		nd = nxt;
+		k++;
+	}
+	if (k == 0)
+		return 0;
+
+	l->len -= k;
+	if (l->len == 0) {
+		l->head = NULL;
+		l->tail = NULL;
+	} else {
+		l->head = nd;
+		nd->prev = l->tail;
+		l->tail->next = nd;
+	}
+	fl_moments_merge(&l->mom, &gone, 0);
+	fl_win_measures_(l);
+	return k;
+}
+
+
+/**
+ * allocate memory for and initialize new windowed flist keeping the values
+ * of the last `span` time units, or all values until expired explicitly if
+ * `span` is 0
+ *
+ * @nolan-h-hamilton
+ */
+flist_win fl_win_make_flist(double span)
+{
+	if (span < 0) {
+		printf("\nfl_win_make_flist(): `span` must be >= 0...returning NULL\n");
+		return NULL;
+	}
+	flist_win l = (flist_win) calloc(1, sizeof(flist_win_type));
+	if (l == NULL) {
+		printf("\nmemory allocation for flist_win failed..returning NULL\n");
+		return NULL;
+	}
+	l->span = span;
+	return l;
+}
+
+
+/**
+ * append value `n` observed at time `t` in O(1) amortized. timestamps must
+ * not decrease. if a window length is set, values before t - span are
+ * expired first.
+ *
+ * @nolan-h-hamilton
+ */
+flist_win fl_win_append(flist_win l, double n, double t)
+{
+	if (l == NULL) {
+		printf("\nfl_win_append(): flist `l` does not exist...returning NULL\n");
+		return NULL;
+	}
+	if (l->len > 0 && t < l->tail->ts) {
+		printf("\nfl_win_append(): timestamp is older than the tail's\n");
+		return l;
+	}
+	if (l->span > 0)
+		fl_win_drop_(l, t - l->span, l->len);
+
+	if (!fl_win_dq_reserve_(&l->mins) || !fl_win_dq_reserve_(&l->maxs))
+		return NULL;
+	fl_win_node nd = (fl_win_node) malloc(sizeof(fl_win_node_type));
+	if (nd == NULL) {
+		printf("\nfl_win_append(): memory allocation for node failed...returning NULL\n");
+		return NULL;
+	}
+	nd->num = n;
+	nd->ts = t;
+
+	/* values that can no longer be the window's min (max) leave the deque */
+	while (l->mins.len > 0 && fl_win_dq_back_(&l->mins)->num > n)
+		l->mins.len--;
+	while (l->maxs.len > 0 && fl_win_dq_back_(&l->maxs)->num < n)
+		l->maxs.len--;
+	fl_win_dq_push_(&l->mins, nd);
+	fl_win_dq_push_(&l->maxs, nd);
+
+	if (l->len == 0) {
+		l->head = nd;
+		l->tail = nd;
+		nd->next = nd;
+		nd->prev = nd;
+	} else {
+		nd->prev = l->tail;
+		nd->next = l->head;
+		l->tail->next = nd;
+		l->head->prev = nd;
+		l->tail = nd;
+	}
+	l->len++;
+	fl_moments_type x = fl_moments_of(n, 1);
+	fl_moments_merge(&l->mom, &x, 1);
+	fl_win_measures_(l);
+	return l;
+}
+
+
+/**
+ * pop every value with timestamp < `t` in one batch, updating the measures
+ * once. returns the number of values expired.
+ *
+ * @nolan-h-hamilton
+ */
+int fl_win_expire_before(flist_win l, double t)
+{
+	if (l == NULL) {
+		printf("\nfl_win_expire_before(): flist `l` is NULL...returning 0\n");
+		return 0;
+	}
+	return fl_win_drop_(l, t, l->len);
+}
+
+
+/**
+ * move the window to end at time `t`, expiring values before t - span.
+ * call before reading the measures when no value has arrived for a while.
+ *
+ * @nolan-h-hamilton
+ */
+int fl_win_advance(flist_win l, double t)
+{
+	if (l == NULL) {
+		printf("\nfl_win_advance(): flist `l` is NULL...returning 0\n");
+		return 0;
+	}
+	if (l->span <= 0)
+		return 0;
+	return fl_win_drop_(l, t - l->span, l->len);
+}
+
+
+double fl_win_pop(flist_win l)
+{
+	if (l == NULL || l->len == 0) {
+		printf("\nfl_win_pop(): cannot pop empty flist\n");
+		exit(1);
+	}
+	double ret = l->head->num;
+	fl_win_drop_(l, INFINITY, 1);
+	return ret;
+}
+
+
+void fl_win_destroy(flist_win l)
+{
+	if (l == NULL) {
+		printf("\nfl_win_destroy(): flist `l` does not exist...\n");
+		return;
+	}
+	fl_win_node nd = l->head;
+	for (int i = 0; i < l->len; i++) {
+		fl_win_node cpy = nd->next;
+		free(nd);
+		nd = cpy;
+	}
+	free(l->mins.buf);
+	free(l->maxs.buf);
+	free(l);
+}
+
+
+double * fl_win_to_arr(flist_win l)
+{
+	if (l == NULL || l->len == 0)
+		return NULL;
+	double * arr = (double *) malloc(sizeof(double) * l->len);
+	if (arr == NULL) {
+		printf("\nfl_win_to_arr(): memory allocation for array failed\n");
+		return NULL;
+	}
+	fl_win_node nd = l->head;
+	for (int i = 0; i < l->len; i++) {
+		arr[i] = nd->num;
+		nd = nd->next;
+	}
+	return arr;
+}
@@ -0,0 +1,87 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+
+/**
+ * flist_win is an flist of timestamped values that keeps statistics over a
+ * trailing time window.
+ *
+ * values are appended with non-decreasing timestamps, so the oldest values
+ * are always at the head. fl_win_expire_before() pops every value older than
+ * a cutoff in one batch with a single aggregated update of len, sum, sumsq,
+ * mean, variance and std_dev; if a window length `span` is set, appending a
+ * value at time t (or calling fl_win_advance(t)) expires everything before
+ * t - span. min and max are maintained with monotonic deques, so every
+ * measure reflects exactly the window at amortized O(1) cost per sample.
+ *
+ * @nolan-h-hamilton
+ */
+
+
+#ifndef FLIST_WINDOW_H_
+#define FLIST_WINDOW_H_
+
+#include "flist.h"
+
+/* Structs */
+
+typedef struct fl_win_node {
+	double num;
+	double ts;
+	struct fl_win_node *prev;
+	struct fl_win_node *next;
+} fl_win_node_type, *fl_win_node;
+
+/* circular buffer of nodes whose values are monotonic from front to back */
+typedef struct {
+	fl_win_node *buf;
+	int cap;
+	int start;
+	int len;
+} fl_win_deque;
+
+typedef struct {
+	fl_win_node head;
+	fl_win_node tail;
+	double mean;
+	double variance;
+	double std_dev;
+	double sumsq;
+	double sum;
+	int len;
+	/* compensated sums and central moments of the window, see fl_moments_merge() */
+	fl_moments_type mom;
+	/* 0 while empty */
+	double min;
+	double max;
+	/* window length; 0 expires only through fl_win_expire_before() */
+	double span;
+	fl_win_deque mins;
+	fl_win_deque maxs;
+} flist_win_type, *flist_win;
+
+/***************/
+
+/* Functions */
+
+/* allocate a windowed flist keeping the values of the last `span` time units (0: no automatic expiry) */
+flist_win fl_win_make_flist(double span);
+
+/* append `n` observed at time `t` >= the tail's timestamp, expiring values before t - span. O(1) amortized */
+flist_win fl_win_append(flist_win l, double n, double t);
+
+/* pop every value with timestamp < `t` and update the measures once. returns the count popped */
+int fl_win_expire_before(flist_win l, double t);
+
+/* expire values before t - span without appending */
+int fl_win_advance(flist_win l, double t);
+
+/* remove and return the oldest value. O(1) amortized */
+double fl_win_pop(flist_win l);
+
+void fl_win_destroy(flist_win l);
+
+double * fl_win_to_arr(flist_win l);
+/*********************/
+
+#endif